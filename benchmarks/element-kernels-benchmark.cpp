@@ -0,0 +1,115 @@
+/*
+    element-kernels-benchmark.cpp
+
+    Times every operation of every implementation of the merge kernels the running processor supports against std::set_* with a back_inserter,
+    which is what array-layout sets were combined with before, on random sorted arrays of equal sizes sharing about half of their ids
+*/
+#include "element-kernels.hpp"
+
+#include <nowide/iostream.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iterator>
+#include <random>
+#include <vector>
+
+namespace {
+    std::vector<ElementId> randomIds(std::mt19937& random, size_t size, uint64_t range) noexcept {
+        std::uniform_int_distribution<uint64_t> distribution(0, range - 1);
+        std::vector<ElementId> ids;
+        while (ids.size() < size) {
+            for (size_t i = ids.size(); i < size; ++i) {
+                ids.push_back(static_cast<ElementId>(distribution(random)));
+            }
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        }
+        return ids;
+    }
+
+    // the fastest of a few runs of operation, in nanoseconds per id of both arrays, after a run to warm up the caches
+    template<typename Operation>
+    double time(Operation operation, size_t ids) noexcept {
+        operation();
+        double fastest = 0;
+        for (int run = 0; run < 5; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            operation();
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            if (run == 0 || elapsed.count() < fastest) {
+                fastest = elapsed.count();
+            }
+        }
+        return fastest / ids;
+    }
+
+    const char* levelName(KernelLevel level) noexcept {
+        switch (level) {
+            case KernelLevel::AVX2:
+                return "AVX2";
+            case KernelLevel::SSE4_2:
+                return "SSE4.2";
+            default:
+                return "scalar";
+        }
+    }
+}
+
+int main() {
+    typedef void (*Kernel)(const std::vector<ElementId>&, const std::vector<ElementId>&, std::vector<ElementId>&) noexcept;
+    typedef void (*Standard)(const std::vector<ElementId>&, const std::vector<ElementId>&, std::vector<ElementId>&);
+    struct Operation {
+        const char* name;
+        Kernel kernel;
+        Standard standard;
+    };
+    const Operation operations[] = {
+        {"intersection", intersectSorted, [](const auto& ids1, const auto& ids2, auto& result) {
+            std::set_intersection(ids1.begin(), ids1.end(), ids2.begin(), ids2.end(), std::back_inserter(result));
+        }},
+        {"union", uniteSorted, [](const auto& ids1, const auto& ids2, auto& result) {
+            std::set_union(ids1.begin(), ids1.end(), ids2.begin(), ids2.end(), std::back_inserter(result));
+        }},
+        {"difference", differenceSorted, [](const auto& ids1, const auto& ids2, auto& result) {
+            std::set_difference(ids1.begin(), ids1.end(), ids2.begin(), ids2.end(), std::back_inserter(result));
+        }},
+        {"symmetric difference", symmetricDifferenceSorted, [](const auto& ids1, const auto& ids2, auto& result) {
+            std::set_symmetric_difference(ids1.begin(), ids1.end(), ids2.begin(), ids2.end(), std::back_inserter(result));
+        }}
+    };
+    std::vector<KernelLevel> levels = {KernelLevel::SCALAR};
+    if (supportedKernelLevel() >= KernelLevel::SSE4_2) {
+        levels.push_back(KernelLevel::SSE4_2);
+    }
+    if (supportedKernelLevel() >= KernelLevel::AVX2) {
+        levels.push_back(KernelLevel::AVX2);
+    }
+
+    nowide::cout << std::fixed << std::setprecision(2)
+                 << "nanoseconds per id of both arrays, and the speedup over std::set_*\n";
+    std::mt19937 random(5489);
+    for (size_t size : {size_t(1) << 10, size_t(1) << 16, size_t(1) << 22}) {
+        auto ids1 = randomIds(random, size, size * 2);
+        auto ids2 = randomIds(random, size, size * 2);
+        std::vector<ElementId> result;
+        nowide::cout << "\narrays of " << size << " ids\n";
+        for (const auto& operation : operations) {
+            double standard = time([&]() {
+                result.clear();
+                operation.standard(ids1, ids2, result);
+            }, size * 2);
+            nowide::cout << std::setw(22) << operation.name << "  std::set_* " << standard;
+            for (auto level : levels) {
+                useKernelLevel(level);
+                double kernel = time([&]() {
+                    operation.kernel(ids1, ids2, result);
+                }, size * 2);
+                nowide::cout << "  " << levelName(level) << ' ' << kernel << " (" << standard / kernel << "x)";
+            }
+            nowide::cout << '\n';
+        }
+    }
+    useKernelLevel(supportedKernelLevel());
+}
\ No newline at end of file
@@ -0,0 +1,567 @@
+/*
+    element-container.cpp
+
+    ElementContainer holds the low 16 bits of every element of an ElementSet that shares the same high 16 bits (a chunk)
+    Like the containers of a compressed (Roaring) bitmap, it keeps the chunk in whichever of three layouts is smallest for it:
+    a sorted array of values for sparse chunks, a 65536 bit bitmap for dense chunks, or a sorted list of runs for clustered chunks
+*/
+#include "element-container.hpp"
+#include "element-kernels.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+
+namespace {
+    constexpr uint32_t CHUNK_VALUES = 65536;
+
+    typedef ElementContainer::Array Array;
+    typedef ElementContainer::Bitmap Bitmap;
+    typedef ElementContainer::Runs Runs;
+
+    bool testBit(const Bitmap& bitmap, uint16_t value) {
+        return (bitmap.words[value >> 6] >> (value & 63)) & 1;
+    }
+
+    // returns the first set bit at or after from, or CHUNK_VALUES if there is none
+    uint32_t nextSetBit(const Bitmap& bitmap, uint32_t from) {
+        uint32_t wordIndex = from >> 6;
+        if (wordIndex >= ElementContainer::BITMAP_WORDS) {
+            return CHUNK_VALUES;
+        }
+        uint64_t word = bitmap.words[wordIndex] & (~uint64_t(0) << (from & 63));
+        while (word == 0) {
+            if (++wordIndex == ElementContainer::BITMAP_WORDS) {
+                return CHUNK_VALUES;
+            }
+            word = bitmap.words[wordIndex];
+        }
+        return (wordIndex << 6) + std::countr_zero(word);
+    }
+
+    Bitmap emptyBitmap() {
+        return Bitmap{std::vector<uint64_t>(ElementContainer::BITMAP_WORDS), 0};
+    }
+
+    Bitmap arrayToBitmap(const Array& array) {
+        Bitmap bitmap = emptyBitmap();
+        for (auto value : array.values) {
+            bitmap.words[value >> 6] |= uint64_t(1) << (value & 63);
+        }
+        bitmap.cardinality = array.values.size();
+        return bitmap;
+    }
+
+    Array bitmapToArray(const Bitmap& bitmap) {
+        Array array;
+        array.values.reserve(bitmap.cardinality);
+        for (uint32_t wordIndex = 0; wordIndex < ElementContainer::BITMAP_WORDS; ++wordIndex) {
+            for (uint64_t word = bitmap.words[wordIndex]; word != 0; word &= word - 1) {
+                array.values.push_back((wordIndex << 6) + std::countr_zero(word));
+            }
+        }
+        return array;
+    }
+
+    uint32_t runsCardinality(const Runs& runs) {
+        uint32_t cardinality = 0;
+        for (const auto& run : runs.runs) {
+            cardinality += uint32_t(run.length) + 1;
+        }
+        return cardinality;
+    }
+
+    // applies op to every word of bitmap1 and bitmap2, recounting the cardinality of the result
+    template <typename TOperation>
+    Bitmap combineBitmaps(const Bitmap& bitmap1, const Bitmap& bitmap2, TOperation op) {
+        Bitmap result = emptyBitmap();
+        uint32_t cardinality = 0;
+        for (uint32_t wordIndex = 0; wordIndex < ElementContainer::BITMAP_WORDS; ++wordIndex) {
+            result.words[wordIndex] = op(bitmap1.words[wordIndex], bitmap2.words[wordIndex]);
+            cardinality += std::popcount(result.words[wordIndex]);
+        }
+        result.cardinality = cardinality;
+        return result;
+    }
+}
+
+ElementContainer::ElementContainer() noexcept
+    : layout_(Array())
+{}
+
+ElementContainer::ElementContainer(std::vector<uint16_t>&& values) noexcept
+    : layout_(Array{std::move(values)})
+{
+    normalize();
+}
+
+ElementContainer::ElementContainer(Array&& array) noexcept
+    : layout_(std::move(array))
+{}
+
+ElementContainer::ElementContainer(Bitmap&& bitmap) noexcept
+    : layout_(std::move(bitmap))
+{}
+
+bool ElementContainer::insert(uint16_t value) noexcept {
+    expandRuns();
+    if (auto* array = std::get_if<Array>(&layout_)) {
+        auto valueIt = std::lower_bound(array->values.begin(), array->values.end(), value);
+        if (valueIt != array->values.end() && *valueIt == value) {
+            return false;
+        }
+        array->values.insert(valueIt, value);
+        normalize();
+        return true;
+    }
+
+    auto& bitmap = std::get<Bitmap>(layout_);
+    if (testBit(bitmap, value)) {
+        return false;
+    }
+    bitmap.words[value >> 6] |= uint64_t(1) << (value & 63);
+    ++bitmap.cardinality;
+    return true;
+}
+
+bool ElementContainer::erase(uint16_t value) noexcept {
+    if (!contains(value)) {
+        return false;
+    }
+    expandRuns();
+    if (auto* array = std::get_if<Array>(&layout_)) {
+        array->values.erase(std::lower_bound(array->values.begin(), array->values.end(), value));
+        return true;
+    }
+
+    auto& bitmap = std::get<Bitmap>(layout_);
+    bitmap.words[value >> 6] &= ~(uint64_t(1) << (value & 63));
+    --bitmap.cardinality;
+    normalize();
+    return true;
+}
+
+bool ElementContainer::contains(uint16_t value) const noexcept {
+    if (const auto* array = std::get_if<Array>(&layout_)) {
+        return std::binary_search(array->values.begin(), array->values.end(), value);
+    } else if (const auto* bitmap = std::get_if<Bitmap>(&layout_)) {
+        return testBit(*bitmap, value);
+    }
+    const auto& runs = std::get<Runs>(layout_).runs;
+    // finds the last run starting at or before value
+    auto runIt = std::upper_bound(runs.begin(), runs.end(), value, [](uint16_t value, const Run& run) {
+        return value < run.start;
+    });
+    if (runIt == runs.begin()) {
+        return false;
+    }
+    --runIt;
+    return uint32_t(value) <= uint32_t(runIt->start) + runIt->length;
+}
+
+uint32_t ElementContainer::cardinality() const noexcept {
+    if (const auto* array = std::get_if<Array>(&layout_)) {
+        return array->values.size();
+    } else if (const auto* bitmap = std::get_if<Bitmap>(&layout_)) {
+        return bitmap->cardinality;
+    }
+    return runsCardinality(std::get<Runs>(layout_));
+}
+
+bool ElementContainer::empty() const noexcept {
+    return cardinality() == 0;
+}
+
+uint32_t ElementContainer::sizeInBytes() const noexcept {
+    if (const auto* array = std::get_if<Array>(&layout_)) {
+        return array->values.size() * sizeof(uint16_t);
+    } else if (std::holds_alternative<Bitmap>(layout_)) {
+        return BITMAP_WORDS * sizeof(uint64_t);
+    }
+    return std::get<Runs>(layout_).runs.size() * sizeof(Run);
+}
+
+ElementContainer::Cursor ElementContainer::first() const noexcept {
+    if (const auto* bitmap = std::get_if<Bitmap>(&layout_)) {
+        return Cursor{nextSetBit(*bitmap, 0), 0};
+    }
+    return Cursor{0, 0};
+}
+
+bool ElementContainer::atEnd(const Cursor& cursor) const noexcept {
+    if (const auto* array = std::get_if<Array>(&layout_)) {
+        return cursor.position >= array->values.size();
+    } else if (std::holds_alternative<Bitmap>(layout_)) {
+        return cursor.position >= CHUNK_VALUES;
+    }
+    return cursor.position >= std::get<Runs>(layout_).runs.size();
+}
+
+uint16_t ElementContainer::value(const Cursor& cursor) const noexcept {
+    if (const auto* array = std::get_if<Array>(&layout_)) {
+        return array->values[cursor.position];
+    } else if (std::holds_alternative<Bitmap>(layout_)) {
+        return cursor.position;
+    }
+    return std::get<Runs>(layout_).runs[cursor.position].start + cursor.offset;
+}
+
+void ElementContainer::next(Cursor& cursor) const noexcept {
+    if (std::holds_alternative<Array>(layout_)) {
+        ++cursor.position;
+    } else if (const auto* bitmap = std::get_if<Bitmap>(&layout_)) {
+        cursor.position = nextSetBit(*bitmap, cursor.position + 1);
+    } else {
+        const auto& runs = std::get<Runs>(layout_).runs;
+        if (cursor.offset == runs[cursor.position].length) {
+            ++cursor.position;
+            cursor.offset = 0;
+        } else {
+            ++cursor.offset;
+        }
+    }
+}
+
+uint32_t ElementContainer::runCount() const noexcept {
+    if (const auto* array = std::get_if<Array>(&layout_)) {
+        uint32_t runs = 0;
+        for (size_t i = 0; i < array->values.size(); ++i) {
+            if (i == 0 || array->values[i] != array->values[i - 1] + 1) {
+                ++runs;
+            }
+        }
+        return runs;
+    } else if (const auto* bitmap = std::get_if<Bitmap>(&layout_)) {
+        // a run starts at every set bit whose preceding bit is unset
+        uint32_t runs = 0;
+        uint64_t previousWord = 0;
+        for (auto word : bitmap->words) {
+            runs += std::popcount(word & ~((word << 1) | (previousWord >> 63)));
+            previousWord = word;
+        }
+        return runs;
+    }
+    return std::get<Runs>(layout_).runs.size();
+}
+
+void ElementContainer::expandRuns() noexcept {
+    const auto* runs = std::get_if<Runs>(&layout_);
+    if (runs == nullptr) {
+        return;
+    }
+
+    if (runsCardinality(*runs) <= ARRAY_MAX_CARDINALITY) {
+        Array array;
+        array.values.reserve(runsCardinality(*runs));
+        for (const auto& run : runs->runs) {
+            for (uint32_t value = run.start; value <= uint32_t(run.start) + run.length; ++value) {
+                array.values.push_back(value);
+            }
+        }
+        layout_ = std::move(array);
+    } else {
+        Bitmap bitmap = emptyBitmap();
+        for (const auto& run : runs->runs) {
+            for (uint32_t value = run.start; value <= uint32_t(run.start) + run.length; ++value) {
+                bitmap.words[value >> 6] |= uint64_t(1) << (value & 63);
+            }
+        }
+        bitmap.cardinality = runsCardinality(*runs);
+        layout_ = std::move(bitmap);
+    }
+}
+
+void ElementContainer::normalize() noexcept {
+    if (const auto* array = std::get_if<Array>(&layout_)) {
+        if (array->values.size() > ARRAY_MAX_CARDINALITY) {
+            layout_ = arrayToBitmap(*array);
+        }
+    } else if (const auto* bitmap = std::get_if<Bitmap>(&layout_)) {
+        if (bitmap->cardinality <= ARRAY_MAX_CARDINALITY) {
+            layout_ = bitmapToArray(*bitmap);
+        }
+    }
+}
+
+void ElementContainer::optimize() noexcept {
+    uint32_t runs = runCount();
+    uint32_t card = cardinality();
+    // sizes in bytes of each layout
+    uint32_t runsSize = runs * sizeof(Run);
+    uint32_t arraySize = card * sizeof(uint16_t);
+    uint32_t bitmapSize = BITMAP_WORDS * sizeof(uint64_t);
+
+    if (runsSize < std::min(arraySize, bitmapSize)) {
+        if (std::holds_alternative<Runs>(layout_)) {
+            return;
+        }
+        Runs newRuns;
+        newRuns.runs.reserve(runs);
+        for (auto cursor = first(); !atEnd(cursor); next(cursor)) {
+            uint16_t current = value(cursor);
+            if (!newRuns.runs.empty() && uint32_t(newRuns.runs.back().start) + newRuns.runs.back().length + 1 == current) {
+                ++newRuns.runs.back().length;
+            } else {
+                newRuns.runs.push_back(Run{current, 0});
+            }
+        }
+        layout_ = std::move(newRuns);
+    } else {
+        expandRuns();
+        normalize();
+    }
+}
+
+ElementContainer ElementContainer::intersect(const ElementContainer& container1, const ElementContainer& container2) noexcept {
+    if (std::holds_alternative<Runs>(container1.layout_)) {
+        ElementContainer expanded = container1;
+        expanded.expandRuns();
+        return intersect(expanded, container2);
+    }
+    if (std::holds_alternative<Runs>(container2.layout_)) {
+        ElementContainer expanded = container2;
+        expanded.expandRuns();
+        return intersect(container1, expanded);
+    }
+
+    const auto* array1 = std::get_if<Array>(&container1.layout_);
+    const auto* array2 = std::get_if<Array>(&container2.layout_);
+    if (array1 != nullptr && array2 != nullptr) {
+        Array result;
+        result.values.reserve(std::min(array1->values.size(), array2->values.size()));
+        if (shouldGallop(array1->values.size(), array2->values.size())) {
+            intersectGalloping(array1->values, array2->values, result.values);
+        } else {
+            std::set_intersection(
+                array1->values.begin(), array1->values.end(),
+                array2->values.begin(), array2->values.end(),
+                std::back_inserter(result.values)
+            );
+        }
+        return ElementContainer(std::move(result));
+    } else if (array1 != nullptr || array2 != nullptr) {
+        // an array can only ever intersect into an array, so only its values need probing in the bitmap
+        const auto& array = array1 != nullptr ? *array1 : *array2;
+        const auto& bitmap = std::get<Bitmap>(array1 != nullptr ? container2.layout_ : container1.layout_);
+        Array result;
+        result.values.reserve(array.values.size());
+        for (auto value : array.values) {
+            if (testBit(bitmap, value)) {
+                result.values.push_back(value);
+            }
+        }
+        return ElementContainer(std::move(result));
+    }
+
+    ElementContainer result(combineBitmaps(std::get<Bitmap>(container1.layout_), std::get<Bitmap>(container2.layout_), [](uint64_t word1, uint64_t word2) {
+        return word1 & word2;
+    }));
+    result.normalize();
+    return result;
+}
+
+ElementContainer ElementContainer::unite(const ElementContainer& container1, const ElementContainer& container2) noexcept {
+    if (std::holds_alternative<Runs>(container1.layout_)) {
+        ElementContainer expanded = container1;
+        expanded.expandRuns();
+        return unite(expanded, container2);
+    }
+    if (std::holds_alternative<Runs>(container2.layout_)) {
+        ElementContainer expanded = container2;
+        expanded.expandRuns();
+        return unite(container1, expanded);
+    }
+
+    const auto* array1 = std::get_if<Array>(&container1.layout_);
+    const auto* array2 = std::get_if<Array>(&container2.layout_);
+    if (array1 != nullptr && array2 != nullptr) {
+        Array result;
+        result.values.reserve(array1->values.size() + array2->values.size());
+        std::set_union(
+            array1->values.begin(), array1->values.end(),
+            array2->values.begin(), array2->values.end(),
+            std::back_inserter(result.values)
+        );
+        ElementContainer container(std::move(result));
+        container.normalize();
+        return container;
+    } else if (array1 != nullptr || array2 != nullptr) {
+        const auto& array = array1 != nullptr ? *array1 : *array2;
+        Bitmap result = std::get<Bitmap>(array1 != nullptr ? container2.layout_ : container1.layout_);
+        for (auto value : array.values) {
+            uint64_t bit = uint64_t(1) << (value & 63);
+            result.cardinality += (result.words[value >> 6] & bit) == 0;
+            result.words[value >> 6] |= bit;
+        }
+        return ElementContainer(std::move(result));
+    }
+
+    return ElementContainer(combineBitmaps(std::get<Bitmap>(container1.layout_), std::get<Bitmap>(container2.layout_), [](uint64_t word1, uint64_t word2) {
+        return word1 | word2;
+    }));
+}
+
+ElementContainer ElementContainer::difference(const ElementContainer& container1, const ElementContainer& container2) noexcept {
+    if (std::holds_alternative<Runs>(container1.layout_)) {
+        ElementContainer expanded = container1;
+        expanded.expandRuns();
+        return difference(expanded, container2);
+    }
+    if (std::holds_alternative<Runs>(container2.layout_)) {
+        ElementContainer expanded = container2;
+        expanded.expandRuns();
+        return difference(container1, expanded);
+    }
+
+    const auto* array1 = std::get_if<Array>(&container1.layout_);
+    const auto* array2 = std::get_if<Array>(&container2.layout_);
+    if (array1 != nullptr && array2 != nullptr) {
+        Array result;
+        result.values.reserve(array1->values.size());
+        if (shouldGallop(array1->values.size(), array2->values.size())) {
+            differenceGalloping(array1->values, array2->values, result.values);
+        } else {
+            std::set_difference(
+                array1->values.begin(), array1->values.end(),
+                array2->values.begin(), array2->values.end(),
+                std::back_inserter(result.values)
+            );
+        }
+        return ElementContainer(std::move(result));
+    } else if (array1 != nullptr) {
+        const auto& bitmap2 = std::get<Bitmap>(container2.layout_);
+        Array result;
+        result.values.reserve(array1->values.size());
+        for (auto value : array1->values) {
+            if (!testBit(bitmap2, value)) {
+                result.values.push_back(value);
+            }
+        }
+        return ElementContainer(std::move(result));
+    } else if (array2 != nullptr) {
+        Bitmap result = std::get<Bitmap>(container1.layout_);
+        for (auto value : array2->values) {
+            uint64_t bit = uint64_t(1) << (value & 63);
+            result.cardinality -= (result.words[value >> 6] & bit) != 0;
+            result.words[value >> 6] &= ~bit;
+        }
+        ElementContainer container(std::move(result));
+        container.normalize();
+        return container;
+    }
+
+    ElementContainer result(combineBitmaps(std::get<Bitmap>(container1.layout_), std::get<Bitmap>(container2.layout_), [](uint64_t word1, uint64_t word2) {
+        return word1 & ~word2;
+    }));
+    result.normalize();
+    return result;
+}
+
+ElementContainer ElementContainer::symmetricDifference(const ElementContainer& container1, const ElementContainer& container2) noexcept {
+    if (std::holds_alternative<Runs>(container1.layout_)) {
+        ElementContainer expanded = container1;
+        expanded.expandRuns();
+        return symmetricDifference(expanded, container2);
+    }
+    if (std::holds_alternative<Runs>(container2.layout_)) {
+        ElementContainer expanded = container2;
+        expanded.expandRuns();
+        return symmetricDifference(container1, expanded);
+    }
+
+    const auto* array1 = std::get_if<Array>(&container1.layout_);
+    const auto* array2 = std::get_if<Array>(&container2.layout_);
+    if (array1 != nullptr && array2 != nullptr) {
+        Array result;
+        result.values.reserve(array1->values.size() + array2->values.size());
+        std::set_symmetric_difference(
+            array1->values.begin(), array1->values.end(),
+            array2->values.begin(), array2->values.end(),
+            std::back_inserter(result.values)
+        );
+        ElementContainer container(std::move(result));
+        container.normalize();
+        return container;
+    } else if (array1 != nullptr || array2 != nullptr) {
+        const auto& array = array1 != nullptr ? *array1 : *array2;
+        Bitmap result = std::get<Bitmap>(array1 != nullptr ? container2.layout_ : container1.layout_);
+        for (auto value : array.values) {
+            uint64_t bit = uint64_t(1) << (value & 63);
+            if ((result.words[value >> 6] & bit) != 0) {
+                --result.cardinality;
+            } else {
+                ++result.cardinality;
+            }
+            result.words[value >> 6] ^= bit;
+        }
+        ElementContainer container(std::move(result));
+        container.normalize();
+        return container;
+    }
+
+    ElementContainer result(combineBitmaps(std::get<Bitmap>(container1.layout_), std::get<Bitmap>(container2.layout_), [](uint64_t word1, uint64_t word2) {
+        return word1 ^ word2;
+    }));
+    result.normalize();
+    return result;
+}
+
+ElementContainer ElementContainer::unite(const std::vector<const ElementContainer*>& containers) noexcept {
+    uint32_t totalCardinality = 0;
+    for (const auto* container : containers) {
+        totalCardinality += container->cardinality();
+    }
+
+    if (totalCardinality > ARRAY_MAX_CARDINALITY) {
+        Bitmap result = emptyBitmap();
+        for (const auto* container : containers) {
+            if (const auto* bitmap = std::get_if<Bitmap>(&container->layout_)) {
+                for (uint32_t wordIndex = 0; wordIndex < BITMAP_WORDS; ++wordIndex) {
+                    result.words[wordIndex] |= bitmap->words[wordIndex];
+                }
+            } else {
+                for (auto cursor = container->first(); !container->atEnd(cursor); container->next(cursor)) {
+                    uint16_t value = container->value(cursor);
+                    result.words[value >> 6] |= uint64_t(1) << (value & 63);
+                }
+            }
+        }
+        for (auto word : result.words) {
+            result.cardinality += std::popcount(word);
+        }
+        ElementContainer container(std::move(result));
+        container.normalize();
+        return container;
+    }
+
+    // a min-heap of the next value of every container that still has values left
+    typedef std::pair<uint16_t, size_t> HeapEntry;
+    std::vector<HeapEntry> heap;
+    std::vector<Cursor> cursors;
+    heap.reserve(containers.size());
+    cursors.reserve(containers.size());
+    for (size_t i = 0; i < containers.size(); ++i) {
+        cursors.push_back(containers[i]->first());
+        if (!containers[i]->atEnd(cursors[i])) {
+            heap.emplace_back(containers[i]->value(cursors[i]), i);
+        }
+    }
+    std::make_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+
+    Array result;
+    result.values.reserve(totalCardinality);
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+        auto [value, i] = heap.back();
+        heap.pop_back();
+        if (result.values.empty() || result.values.back() != value) {
+            result.values.push_back(value);
+        }
+        containers[i]->next(cursors[i]);
+        if (!containers[i]->atEnd(cursors[i])) {
+            heap.emplace_back(containers[i]->value(cursors[i]), i);
+            std::push_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+        }
+    }
+    return ElementContainer(std::move(result));
+}
\ No newline at end of file
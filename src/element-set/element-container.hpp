@@ -0,0 +1,81 @@
+/*
+    element-container.hpp
+
+    ElementContainer holds the low 16 bits of every element of an ElementSet that shares the same high 16 bits (a chunk)
+    Like the containers of a compressed (Roaring) bitmap, it keeps the chunk in whichever of three layouts is smallest for it:
+    a sorted array of values for sparse chunks, a 65536 bit bitmap for dense chunks, or a sorted list of runs for clustered chunks
+*/
+#pragma once
+
+#include <cstdint>
+#include <variant>
+#include <vector>
+
+class ElementContainer {
+    public:
+        // a run of consecutive values covering start to start + length inclusive
+        struct Run {
+            uint16_t start;
+            uint16_t length;
+        };
+        struct Array {
+            std::vector<uint16_t> values;
+        };
+        struct Bitmap {
+            std::vector<uint64_t> words;
+            uint32_t cardinality;
+        };
+        struct Runs {
+            std::vector<Run> runs;
+        };
+
+        // a position within a container, its meaning depends on the layout of the container it was taken from
+        struct Cursor {
+            uint32_t position;
+            uint32_t offset;
+
+            bool operator==(const Cursor& other) const noexcept = default;
+        };
+
+        ElementContainer() noexcept;
+        // takes values that are already sorted and unique
+        explicit ElementContainer(std::vector<uint16_t>&& values) noexcept;
+
+        bool insert(uint16_t value) noexcept;
+        bool erase(uint16_t value) noexcept;
+        bool contains(uint16_t value) const noexcept;
+        uint32_t cardinality() const noexcept;
+        bool empty() const noexcept;
+        // the number of bytes taken by the values of the container in its current layout
+        uint32_t sizeInBytes() const noexcept;
+
+        Cursor first() const noexcept;
+        bool atEnd(const Cursor& cursor) const noexcept;
+        uint16_t value(const Cursor& cursor) const noexcept;
+        void next(Cursor& cursor) const noexcept;
+
+        // converts the container to whichever layout takes the least memory for its values
+        void optimize() noexcept;
+
+        static ElementContainer intersect(const ElementContainer& container1, const ElementContainer& container2) noexcept;
+        static ElementContainer unite(const ElementContainer& container1, const ElementContainer& container2) noexcept;
+        static ElementContainer difference(const ElementContainer& container1, const ElementContainer& container2) noexcept;
+        static ElementContainer symmetricDifference(const ElementContainer& container1, const ElementContainer& container2) noexcept;
+        // unites any number of containers at once, with a k-way merge when the result can be an array and by ORing into one bitmap otherwise
+        static ElementContainer unite(const std::vector<const ElementContainer*>& containers) noexcept;
+
+        // arrays larger than this take more memory than a bitmap does
+        static constexpr uint32_t ARRAY_MAX_CARDINALITY = 4096;
+        static constexpr uint32_t BITMAP_WORDS = 1024;
+    private:
+        ElementContainer(Array&& array) noexcept;
+        ElementContainer(Bitmap&& bitmap) noexcept;
+
+        // expands a run layout into an array or bitmap layout so that it can be mutated or combined
+        void expandRuns() noexcept;
+        // keeps arrays at or under ARRAY_MAX_CARDINALITY and bitmaps over it
+        void normalize() noexcept;
+        uint32_t runCount() const noexcept;
+
+        std::variant<Array, Bitmap, Runs> layout_;
+};
\ No newline at end of file
@@ -0,0 +1,110 @@
+/*
+    element-dictionary.cpp
+
+    ElementDictionary interns every distinct element string of a set hierarchy and maps it to a dense ElementId
+    A single dictionary is owned by the GlobalSet, so that every set in the hierarchy can store and compare ElementIds instead of strings
+*/
+#include "element-dictionary.hpp"
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+    size_t hashOf(std::string_view element) noexcept {
+        // the lowest bit is set, so that no hash is zero, which marks an empty slot
+        return std::hash<std::string_view>()(element) | 1;
+    }
+}
+
+ElementId ElementDictionary::intern(std::string_view element) noexcept {
+    return insert(element, true);
+}
+
+ElementId ElementDictionary::internView(std::string_view element) noexcept {
+    return insert(element, false);
+}
+
+ElementId ElementDictionary::insert(std::string_view element, bool copy) noexcept {
+    grow(elements_.size() + 1);
+    auto hash = hashOf(element);
+    auto& found = ids_[slot(element, hash)];
+    if (found.hash != 0) {
+        return found.id;
+    }
+
+    ElementId id = static_cast<ElementId>(elements_.size());
+    elements_.push_back(copy ? std::string_view(copies_.emplace_back(element)) : element);
+    found = {hash, elements_.back().data(), static_cast<uint32_t>(element.size()), id};
+    return id;
+}
+
+size_t ElementDictionary::slot(std::string_view element, size_t hash) const noexcept {
+    size_t mask = ids_.size() - 1;
+    for (size_t index = hash & mask;; index = (index + 1) & mask) {
+        const auto& slot = ids_[index];
+        if (slot.hash == 0 || (slot.hash == hash && std::string_view(slot.data, slot.size) == element)) {
+            return index;
+        }
+    }
+}
+
+void ElementDictionary::grow(size_t count) noexcept {
+    if (count * 2 <= ids_.size()) {
+        return;
+    }
+    size_t size = 16;
+    while (size < count * 2) {
+        size *= 2;
+    }
+    std::vector<Slot> slots(size);
+    std::swap(slots, ids_);
+    for (const auto& slot : slots) {
+        if (slot.hash != 0) {
+            ids_[this->slot(std::string_view(slot.data, slot.size), slot.hash)] = slot;
+        }
+    }
+}
+
+void ElementDictionary::retain(std::shared_ptr<const void> storage) noexcept {
+    storage_.push_back(std::move(storage));
+}
+
+bool ElementDictionary::find(std::string_view element, ElementId& id) const noexcept {
+    if (ids_.empty()) {
+        return false;
+    }
+    const auto& found = ids_[slot(element, hashOf(element))];
+    if (found.hash == 0) {
+        return false;
+    }
+    id = found.id;
+    return true;
+}
+
+std::string_view ElementDictionary::element(ElementId id) const noexcept {
+    return elements_[id];
+}
+
+size_t ElementDictionary::size() const noexcept {
+    return elements_.size();
+}
+
+void ElementDictionary::reserve(size_t count) noexcept {
+    elements_.reserve(elements_.size() + count);
+    grow(elements_.size() + count);
+}
+
+ElementDictionary ElementDictionary::snapshot() const noexcept {
+    ElementDictionary snapshot;
+    snapshot.elements_ = elements_;
+    snapshot.storage_ = storage_;
+    return snapshot;
+}
+
+std::vector<ElementId> ElementDictionary::sorted(const ElementSet& elements) const noexcept {
+    std::vector<ElementId> sortedElements(elements.begin(), elements.end());
+    std::sort(sortedElements.begin(), sortedElements.end(), [this](ElementId id1, ElementId id2) {
+        return elements_[id1] < elements_[id2];
+    });
+    return sortedElements;
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+/*
+    element-dictionary.hpp
+
+    ElementDictionary interns every distinct element string of a set hierarchy and maps it to a dense ElementId
+    A single dictionary is owned by the GlobalSet, so that every set in the hierarchy can store and compare ElementIds instead of strings
+*/
+#pragma once
+
+#include "element-set.hpp"
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <vector>
+#include <memory>
+
+class ElementDictionary {
+    public:
+        // returns the id of element, adding it to the dictionary if it has not been seen before
+        ElementId intern(std::string_view element) noexcept;
+        // the same as intern, but without copying element, which has to stay valid for as long as the dictionary, such as by being within storage it retains
+        ElementId internView(std::string_view element) noexcept;
+        // keeps storage alive for as long as the dictionary, for the elements interned as views into it
+        void retain(std::shared_ptr<const void> storage) noexcept;
+        // returns whether element has been interned, writing its id into id if it has
+        bool find(std::string_view element, ElementId& id) const noexcept;
+        std::string_view element(ElementId id) const noexcept;
+        size_t size() const noexcept;
+        // makes room for count more elements, so that interning as many as that does not rehash along the way
+        void reserve(size_t count) noexcept;
+        // a dictionary of the elements interned so far that can only look them up by id, and shares their strings with this one, which keeps them valid,
+        // so that it can be read on another thread while this one keeps interning
+        ElementDictionary snapshot() const noexcept;
+
+        // returns the ids of elements ordered by their strings, for any output meant to be read by a human
+        std::vector<ElementId> sorted(const ElementSet& elements) const noexcept;
+    private:
+        // an open addressed slot of the table of ids, holding the hash and string of the element next to its id, so that finding it rarely looks anywhere else
+        struct Slot {
+            // zero for an empty slot, which no hash is
+            size_t hash = 0;
+            const char* data;
+            uint32_t size;
+            ElementId id;
+        };
+
+        ElementId insert(std::string_view element, bool copy) noexcept;
+        // the slot of element, or the empty slot it would go in
+        size_t slot(std::string_view element, size_t hash) const noexcept;
+        // resizes the table of ids to fit count elements, keeping it at most half full
+        void grow(size_t count) noexcept;
+
+        std::vector<std::string_view> elements_;
+        // the elements that were copied when interned, where a deque never relocates its strings, so the views of them stay valid
+        std::deque<std::string> copies_;
+        std::vector<std::shared_ptr<const void>> storage_;
+        // a power of two in size, where elements are found by probing linearly from the slot their hash picks
+        std::vector<Slot> ids_;
+};
\ No newline at end of file
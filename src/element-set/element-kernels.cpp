@@ -0,0 +1,587 @@
+/*
+    element-kernels.cpp
+
+    Merge kernels that combine two sorted arrays of unique ElementIds into a sorted array of unique ElementIds
+    Each kernel uses the fastest implementation the running processor supports (AVX2, SSE4.2, or plain scalar code), which is picked the first time a kernel is used
+
+    When one array is much larger than the other, intersections and differences instead gallop (exponentially search) through the larger one,
+    which takes O(m log n) rather than O(m + n) for an array of m ids against one of n
+*/
+#include "element-kernels.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ELEMENT_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+    // kernels write whole vectors of results, so they may write up to this many ids past the end of their result
+    constexpr size_t KERNEL_SLACK = 8;
+
+    // each kernel writes its result to output and returns the number of ids in it
+    typedef size_t (*Kernel)(const ElementId* elements1, size_t size1, const ElementId* elements2, size_t size2, ElementId* output);
+
+    struct Kernels {
+        Kernel intersect;
+        Kernel unite;
+        Kernel difference;
+        Kernel symmetricDifference;
+    };
+
+    size_t intersectScalar(const ElementId* elements1, size_t size1, const ElementId* elements2, size_t size2, ElementId* output) {
+        size_t i = 0;
+        size_t j = 0;
+        size_t count = 0;
+        while (i < size1 && j < size2) {
+            ElementId element1 = elements1[i];
+            ElementId element2 = elements2[j];
+            output[count] = element1;
+            count += element1 == element2;
+            i += element1 <= element2;
+            j += element2 <= element1;
+        }
+        return count;
+    }
+
+    size_t uniteScalar(const ElementId* elements1, size_t size1, const ElementId* elements2, size_t size2, ElementId* output) {
+        size_t i = 0;
+        size_t j = 0;
+        size_t count = 0;
+        while (i < size1 && j < size2) {
+            ElementId element1 = elements1[i];
+            ElementId element2 = elements2[j];
+            output[count++] = std::min(element1, element2);
+            i += element1 <= element2;
+            j += element2 <= element1;
+        }
+        output = std::copy(elements1 + i, elements1 + size1, output + count);
+        std::copy(elements2 + j, elements2 + size2, output);
+        return count + (size1 - i) + (size2 - j);
+    }
+
+    size_t differenceScalar(const ElementId* elements1, size_t size1, const ElementId* elements2, size_t size2, ElementId* output) {
+        size_t i = 0;
+        size_t j = 0;
+        size_t count = 0;
+        while (i < size1 && j < size2) {
+            ElementId element1 = elements1[i];
+            ElementId element2 = elements2[j];
+            output[count] = element1;
+            count += element1 < element2;
+            i += element1 <= element2;
+            j += element2 <= element1;
+        }
+        std::copy(elements1 + i, elements1 + size1, output + count);
+        return count + (size1 - i);
+    }
+
+    size_t symmetricDifferenceScalar(const ElementId* elements1, size_t size1, const ElementId* elements2, size_t size2, ElementId* output) {
+        size_t i = 0;
+        size_t j = 0;
+        size_t count = 0;
+        while (i < size1 && j < size2) {
+            ElementId element1 = elements1[i];
+            ElementId element2 = elements2[j];
+            output[count] = std::min(element1, element2);
+            count += element1 != element2;
+            i += element1 <= element2;
+            j += element2 <= element1;
+        }
+        output = std::copy(elements1 + i, elements1 + size1, output + count);
+        std::copy(elements2 + j, elements2 + size2, output);
+        return count + (size1 - i) + (size2 - j);
+    }
+
+#ifdef ELEMENT_KERNELS_X86
+    // byte shuffles that move the 32 bit lanes selected by a 4 bit mask to the front of a 128 bit vector
+    struct PackTable4 {
+        alignas(16) uint8_t bytes[16][16];
+    };
+
+    constexpr PackTable4 makePackTable4() {
+        PackTable4 table{};
+        for (int mask = 0; mask < 16; ++mask) {
+            int packed = 0;
+            for (int lane = 0; lane < 4; ++lane) {
+                if (mask & (1 << lane)) {
+                    for (int byte = 0; byte < 4; ++byte) {
+                        table.bytes[mask][packed * 4 + byte] = lane * 4 + byte;
+                    }
+                    ++packed;
+                }
+            }
+            for (; packed < 4; ++packed) {
+                for (int byte = 0; byte < 4; ++byte) {
+                    table.bytes[mask][packed * 4 + byte] = 0x80;
+                }
+            }
+        }
+        return table;
+    }
+
+    // lane permutations that move the 32 bit lanes selected by an 8 bit mask to the front of a 256 bit vector
+    struct PackTable8 {
+        alignas(32) uint32_t lanes[256][8];
+    };
+
+    constexpr PackTable8 makePackTable8() {
+        PackTable8 table{};
+        for (int mask = 0; mask < 256; ++mask) {
+            int packed = 0;
+            for (int lane = 0; lane < 8; ++lane) {
+                if (mask & (1 << lane)) {
+                    table.lanes[mask][packed++] = lane;
+                }
+            }
+        }
+        return table;
+    }
+
+    constexpr PackTable4 PACK_TABLE_4 = makePackTable4();
+    constexpr PackTable8 PACK_TABLE_8 = makePackTable8();
+
+    // --- SSE4.2 ---
+
+    // stores the lanes of values selected by mask to output and returns how many were stored
+    __attribute__((target("sse4.2")))
+    size_t packStore4(__m128i values, int mask, ElementId* output) {
+        __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(PACK_TABLE_4.bytes[mask]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_shuffle_epi8(values, shuffle));
+        return std::popcount(static_cast<unsigned>(mask));
+    }
+
+    // returns a 4 bit mask of the lanes of values1 that are equal to any lane of values2
+    __attribute__((target("sse4.2")))
+    int matchMask4(__m128i values1, __m128i values2) {
+        __m128i matches = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi32(values1, values2),
+                _mm_cmpeq_epi32(values1, _mm_shuffle_epi32(values2, _MM_SHUFFLE(0, 3, 2, 1)))
+            ),
+            _mm_or_si128(
+                _mm_cmpeq_epi32(values1, _mm_shuffle_epi32(values2, _MM_SHUFFLE(1, 0, 3, 2))),
+                _mm_cmpeq_epi32(values1, _mm_shuffle_epi32(values2, _MM_SHUFFLE(2, 1, 0, 3)))
+            )
+        );
+        return _mm_movemask_ps(_mm_castsi128_ps(matches));
+    }
+
+    // merges two sorted vectors into the sorted lowest four values (low) and highest four values (high)
+    __attribute__((target("sse4.2")))
+    void merge4(__m128i values1, __m128i values2, __m128i& low, __m128i& high) {
+        __m128i rotated = _mm_min_epu32(values1, values2);
+        high = _mm_max_epu32(values1, values2);
+        for (int round = 0; round < 3; ++round) {
+            rotated = _mm_alignr_epi8(rotated, rotated, 4);
+            low = _mm_min_epu32(rotated, high);
+            high = _mm_max_epu32(rotated, high);
+            rotated = low;
+        }
+        low = _mm_alignr_epi8(low, low, 4);
+    }
+
+    // the lanes of values equal to the lane before them, where the lane before the first is the last lane of previous
+    __attribute__((target("sse4.2")))
+    int repeatMask4(__m128i previous, __m128i values) {
+        return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(values, _mm_alignr_epi8(values, previous, 12))));
+    }
+
+    __attribute__((target("sse4.2")))
+    __m128i load4(const ElementId* elements) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(elements));
+    }
+
+    __attribute__((target("sse4.2")))
+    size_t intersectSse42(const ElementId* elements1, size_t size1, const ElementId* elements2, size_t size2, ElementId* output) {
+        size_t i = 0;
+        size_t j = 0;
+        size_t count = 0;
+        while (i + 4 <= size1 && j + 4 <= size2) {
+            __m128i values1 = load4(elements1 + i);
+            count += packStore4(values1, matchMask4(values1, load4(elements2 + j)), output + count);
+            ElementId last1 = elements1[i + 3];
+            ElementId last2 = elements2[j + 3];
+            i += last1 <= last2 ? 4 : 0;
+            j += last2 <= last1 ? 4 : 0;
+        }
+        // the values of elements1 matched so far are all lower than the rest of elements2, so they cannot be matched again
+        return count + intersectScalar(elements1 + i, size1 - i, elements2 + j, size2 - j, output + count);
+    }
+
+    __attribute__((target("sse4.2")))
+    size_t differenceSse42(const ElementId* elements1, size_t size1, const ElementId* elements2, size_t size2, ElementId* output) {
+        size_t i = 0;
+        size_t j = 0;
+        size_t count = 0;
+        // the lanes of the current block of elements1 found in elements2 so far
+        int found = 0;
+        while (i + 4 <= size1 && j + 4 <= size2) {
+            __m128i values1 = load4(elements1 + i);
+            found |= matchMask4(values1, load4(elements2 + j));
+            ElementId last1 = elements1[i + 3];
+            ElementId last2 = elements2[j + 3];
+            if (last1 <= last2) {
+                count += packStore4(values1, ~found & 0xF, output + count);
+                found = 0;
+                i += 4;
+            }
+            j += last2 <= last1 ? 4 : 0;
+        }
+        if (found != 0) {
+            // the lanes of the current block that were not found may still be in the rest of elements2
+            for (int lane = 0; lane < 4; ++lane) {
+                if ((found & (1 << lane)) == 0) {
+                    ElementId element = elements1[i + lane];
+                    j = std::lower_bound(elements2 + j, elements2 + size2, element) - elements2;
+                    if (j == size2 || elements2[j] != element) {
+                        output[count++] = element;
+                    }
+                }
+            }
+            i += 4;
+        }
+        return count + differenceScalar(elements1 + i, size1 - i, elements2 + j, size2 - j, output + count);
+    }
+
+
+    // merges the rest of three sorted lists of ids, passing each id to sink in order
+    template<typename Sink>
+    void mergeRest(const ElementId* pending, size_t pendingSize, const ElementId* elements1, size_t size1, const ElementId* elements2, size_t size2, Sink& sink) {
+        size_t k = 0;
+        size_t i = 0;
+        size_t j = 0;
+        while (k < pendingSize || i < size1 || j < size2) {
+            ElementId lowest = UINT32_MAX;
+            if (k < pendingSize) {
+                lowest = pending[k];
+            }
+            if (i < size1) {
+                lowest = std::min(lowest, elements1[i]);
+            }
+            if (j < size2) {
+                lowest = std::min(lowest, elements2[j]);
+            }
+            if (k < pendingSize && pending[k] == lowest) {
+                ++k;
+            } else if (i < size1 && elements1[i] == lowest) {
+                ++i;
+            } else {
+                ++j;
+            }
+            sink.value(lowest);
+        }
+    }
+
+    // merges two sorted arrays of at least four ids each, passing each sorted vector of merged ids to sink.block as it is produced,
+    // then passing the ids still held by the merge and the unmerged tails of both arrays to sink.value in order
+    // the merged ids contain each id found in both arrays twice in a row
+    template<typename Sink>
+    __attribute__((target("sse4.2")))
+    void mergeSse42(const ElementId* elements1, size_t size1, const ElementId* elements2, size_t size2, Sink& sink) {
+        size_t blocks1 = size1 / 4 * 4;
+        size_t blocks2 = size2 / 4 * 4;
+        __m128i low;
+        __m128i high;
+        merge4(load4(elements1), load4(elements2), low, high);
+        sink.block(low);
+        size_t i = 4;
+        size_t j = 4;
+        if (i < blocks1 && j < blocks2) {
+            ElementId next1 = elements1[i];
+            ElementId next2 = elements2[j];
+            __m128i values;
+            while (true) {
+                if (next1 <= next2) {
+                    values = load4(elements1 + i);
+                    i += 4;
+                    if (i == blocks1) {
+                        break;
+                    }
+                    next1 = elements1[i];
+                } else {
+                    values = load4(elements2 + j);
+                    j += 4;
+                    if (j == blocks2) {
+                        break;
+                    }
+                    next2 = elements2[j];
+                }
+                merge4(values, high, low, high);
+                sink.block(low);
+            }
+            merge4(values, high, low, high);
+            sink.block(low);
+        }
+        alignas(16) ElementId held[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(held), high);
+        sink.flush();
+        mergeRest(held, 4, elements1 + i, size1 - i, elements2 + j, size2 - j, sink);
+        sink.finish();
+    }
+
+    // keeps only the first of each run of equal merged ids
+    class UniteSink {
+        public:
+            UniteSink(ElementId* output) noexcept : output_(output), count_(0), previous_(_mm_set1_epi32(-1)) {}
+
+            // the first merged vector always holds an id lower than UINT32_MAX, so the all ones vector before it cannot repeat any of it
+            __attribute__((target("sse4.2")))
+            void block(__m128i values) noexcept {
+                count_ += packStore4(values, ~repeatMask4(previous_, values) & 0xF, output_ + count_);
+                previous_ = values;
+            }
+
+            void flush() noexcept {}
+
+            void value(ElementId element) noexcept {
+                if (output_[count_ - 1] != element) {
+                    output_[count_++] = element;
+                }
+            }
+
+            void finish() noexcept {}
+
+            size_t count() const noexcept {
+                return count_;
+            }
+        private:
+            ElementId* output_;
+            size_t count_;
+            __m128i previous_;
+    };
+
+    // keeps only the merged ids equal to neither of their neighbours
+    // each merged vector is held back until the vector after it is known
+    class SymmetricDifferenceSink {
+        public:
+            SymmetricDifferenceSink(ElementId* output) noexcept : output_(output), count_(0), blocks_(0), before_(_mm_setzero_si128()), held_(_mm_setzero_si128()),
+                hasPrevious_(false), hasCurrent_(false), previous_(0), current_(0) {}
+
+            __attribute__((target("sse4.2")))
+            void block(__m128i values) noexcept {
+                if (blocks_ > 0) {
+                    int repeats = repeatMask4(before_, held_) & (blocks_ > 1 ? 0xF : 0xE);
+                    int repeated = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(held_, _mm_alignr_epi8(values, held_, 4))));
+                    count_ += packStore4(held_, ~(repeats | repeated) & 0xF, output_ + count_);
+                    before_ = held_;
+                }
+                held_ = values;
+                ++blocks_;
+            }
+
+            // hands the held vector over to the scalar tail
+            __attribute__((target("sse4.2")))
+            void flush() noexcept {
+                alignas(16) ElementId lanes[4];
+                if (blocks_ > 1) {
+                    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), before_);
+                    hasPrevious_ = true;
+                    previous_ = lanes[3];
+                }
+                _mm_store_si128(reinterpret_cast<__m128i*>(lanes), held_);
+                for (ElementId lane : lanes) {
+                    value(lane);
+                }
+            }
+
+            void value(ElementId element) noexcept {
+                if (hasCurrent_) {
+                    if ((!hasPrevious_ || current_ != previous_) && current_ != element) {
+                        output_[count_++] = current_;
+                    }
+                    previous_ = current_;
+                    hasPrevious_ = true;
+                }
+                current_ = element;
+                hasCurrent_ = true;
+            }
+
+            void finish() noexcept {
+                if (hasCurrent_ && (!hasPrevious_ || current_ != previous_)) {
+                    output_[count_++] = current_;
+                }
+            }
+
+            size_t count() const noexcept {
+                return count_;
+            }
+        private:
+            ElementId* output_;
+            size_t count_;
+            size_t blocks_;
+            __m128i before_;
+            __m128i held_;
+            bool hasPrevious_;
+            bool hasCurrent_;
+            ElementId previous_;
+            ElementId current_;
+    };
+
+    __attribute__((target("sse4.2")))
+    size_t uniteSse42(const ElementId* elements1, size_t size1, const ElementId* elements2, size_t size2, ElementId* output) {
+        if (size1 < 4 || size2 < 4) {
+            return uniteScalar(elements1, size1, elements2, size2, output);
+        }
+        UniteSink sink(output);
+        mergeSse42(elements1, size1, elements2, size2, sink);
+        return sink.count();
+    }
+
+    __attribute__((target("sse4.2")))
+    size_t symmetricDifferenceSse42(const ElementId* elements1, size_t size1, const ElementId* elements2, size_t size2, ElementId* output) {
+        if (size1 < 4 || size2 < 4) {
+            return symmetricDifferenceScalar(elements1, size1, elements2, size2, output);
+        }
+        SymmetricDifferenceSink sink(output);
+        mergeSse42(elements1, size1, elements2, size2, sink);
+        return sink.count();
+    }
+
+    // --- AVX2 ---
+
+    __attribute__((target("avx2")))
+    size_t packStore8(__m256i values, int mask, ElementId* output) {
+        __m256i permutation = _mm256_load_si256(reinterpret_cast<const __m256i*>(PACK_TABLE_8.lanes[mask]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output), _mm256_permutevar8x32_epi32(values, permutation));
+        return std::popcount(static_cast<unsigned>(mask));
+    }
+
+    // returns an 8 bit mask of the lanes of values1 that are equal to any lane of values2
+    __attribute__((target("avx2")))
+    int matchMask8(__m256i values1, __m256i values2) {
+        const __m256i rotation = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+        __m256i matches = _mm256_cmpeq_epi32(values1, values2);
+        for (int lane = 1; lane < 8; ++lane) {
+            values2 = _mm256_permutevar8x32_epi32(values2, rotation);
+            matches = _mm256_or_si256(matches, _mm256_cmpeq_epi32(values1, values2));
+        }
+        return _mm256_movemask_ps(_mm256_castsi256_ps(matches));
+    }
+
+    __attribute__((target("avx2")))
+    __m256i load8(const ElementId* elements) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(elements));
+    }
+
+    __attribute__((target("avx2")))
+    size_t intersectAvx2(const ElementId* elements1, size_t size1, const ElementId* elements2, size_t size2, ElementId* output) {
+        size_t i = 0;
+        size_t j = 0;
+        size_t count = 0;
+        while (i + 8 <= size1 && j + 8 <= size2) {
+            __m256i values1 = load8(elements1 + i);
+            count += packStore8(values1, matchMask8(values1, load8(elements2 + j)), output + count);
+            ElementId last1 = elements1[i + 7];
+            ElementId last2 = elements2[j + 7];
+            i += last1 <= last2 ? 8 : 0;
+            j += last2 <= last1 ? 8 : 0;
+        }
+        return count + intersectSse42(elements1 + i, size1 - i, elements2 + j, size2 - j, output + count);
+    }
+
+    __attribute__((target("avx2")))
+    size_t differenceAvx2(const ElementId* elements1, size_t size1, const ElementId* elements2, size_t size2, ElementId* output) {
+        size_t i = 0;
+        size_t j = 0;
+        size_t count = 0;
+        int found = 0;
+        while (i + 8 <= size1 && j + 8 <= size2) {
+            __m256i values1 = load8(elements1 + i);
+            found |= matchMask8(values1, load8(elements2 + j));
+            ElementId last1 = elements1[i + 7];
+            ElementId last2 = elements2[j + 7];
+            if (last1 <= last2) {
+                count += packStore8(values1, ~found & 0xFF, output + count);
+                found = 0;
+                i += 8;
+            }
+            j += last2 <= last1 ? 8 : 0;
+        }
+        if (found != 0) {
+            for (int lane = 0; lane < 8; ++lane) {
+                if ((found & (1 << lane)) == 0) {
+                    ElementId element = elements1[i + lane];
+                    j = std::lower_bound(elements2 + j, elements2 + size2, element) - elements2;
+                    if (j == size2 || elements2[j] != element) {
+                        output[count++] = element;
+                    }
+                }
+            }
+            i += 8;
+        }
+        return count + differenceSse42(elements1 + i, size1 - i, elements2 + j, size2 - j, output + count);
+    }
+#endif
+
+    Kernels kernelsOf(KernelLevel level) {
+        switch (level) {
+#ifdef ELEMENT_KERNELS_X86
+            case KernelLevel::AVX2:
+                // merging networks gain little from wider vectors, so union and symmetric difference stay on SSE4.2
+                return Kernels{intersectAvx2, uniteSse42, differenceAvx2, symmetricDifferenceSse42};
+            case KernelLevel::SSE4_2:
+                return Kernels{intersectSse42, uniteSse42, differenceSse42, symmetricDifferenceSse42};
+#endif
+            default:
+                return Kernels{intersectScalar, uniteScalar, differenceScalar, symmetricDifferenceScalar};
+        }
+    }
+
+    Kernels& kernels() {
+        static Kernels selected = kernelsOf(supportedKernelLevel());
+        return selected;
+    }
+
+    void run(Kernel kernel, const std::vector<ElementId>& elements1, const std::vector<ElementId>& elements2, size_t maxSize, std::vector<ElementId>& result) {
+        result.resize(maxSize + KERNEL_SLACK);
+        result.resize(kernel(elements1.data(), elements1.size(), elements2.data(), elements2.size(), result.data()));
+    }
+}
+
+KernelLevel supportedKernelLevel() noexcept {
+#ifdef ELEMENT_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return KernelLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return KernelLevel::SSE4_2;
+    }
+#endif
+    return KernelLevel::SCALAR;
+}
+
+void useKernelLevel(KernelLevel level) noexcept {
+    kernels() = kernelsOf(level);
+}
+
+void intersectSorted(const std::vector<ElementId>& elements1, const std::vector<ElementId>& elements2, std::vector<ElementId>& result) noexcept {
+    if (shouldGallop(elements1.size(), elements2.size())) {
+        result.clear();
+        result.reserve(std::min(elements1.size(), elements2.size()));
+        intersectGalloping(elements1, elements2, result);
+        return;
+    }
+    run(kernels().intersect, elements1, elements2, std::min(elements1.size(), elements2.size()), result);
+}
+
+void uniteSorted(const std::vector<ElementId>& elements1, const std::vector<ElementId>& elements2, std::vector<ElementId>& result) noexcept {
+    run(kernels().unite, elements1, elements2, elements1.size() + elements2.size(), result);
+}
+
+void differenceSorted(const std::vector<ElementId>& elements1, const std::vector<ElementId>& elements2, std::vector<ElementId>& result) noexcept {
+    if (shouldGallop(elements1.size(), elements2.size())) {
+        result.clear();
+        result.reserve(elements1.size());
+        differenceGalloping(elements1, elements2, result);
+        return;
+    }
+    run(kernels().difference, elements1, elements2, elements1.size(), result);
+}
+
+void symmetricDifferenceSorted(const std::vector<ElementId>& elements1, const std::vector<ElementId>& elements2, std::vector<ElementId>& result) noexcept {
+    run(kernels().symmetricDifference, elements1, elements2, elements1.size() + elements2.size(), result);
+}
\ No newline at end of file
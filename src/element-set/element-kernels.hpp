@@ -0,0 +1,104 @@
+/*
+    element-kernels.hpp
+
+    Merge kernels that combine two sorted arrays of unique ElementIds into a sorted array of unique ElementIds
+    Each kernel uses the fastest implementation the running processor supports (AVX2, SSE4.2, or plain scalar code), which is picked the first time a kernel is used
+
+    When one array is much larger than the other, intersections and differences instead gallop (exponentially search) through the larger one,
+    which takes O(m log n) rather than O(m + n) for an array of m ids against one of n
+*/
+#pragma once
+
+#include "element-set.hpp"
+
+#include <algorithm>
+#include <vector>
+
+// arrays at least this many times larger than the array they are combined with are galloped through rather than merged
+constexpr size_t GALLOP_RATIO = 32;
+
+inline bool shouldGallop(size_t size1, size_t size2) noexcept {
+    return size1 / GALLOP_RATIO > size2 || size2 / GALLOP_RATIO > size1;
+}
+
+// returns the first position in first to last whose value is not less than value, searching forward from first in exponentially growing steps
+template<typename T>
+const T* gallop(const T* first, const T* last, T value) noexcept {
+    if (first == last || !(*first < value)) {
+        return first;
+    }
+    // everything up to and including low is less than value
+    const T* low = first;
+    size_t step = 1;
+    while (size_t(last - low) > step && low[step] < value) {
+        low += step;
+        step *= 2;
+    }
+    return std::lower_bound(low + 1, size_t(last - low) > step ? low + step : last, value);
+}
+
+// the galloping kernels take sorted and unique values and append their result to result
+template<typename T>
+void intersectGalloping(const std::vector<T>& values1, const std::vector<T>& values2, std::vector<T>& result) noexcept {
+    const auto& smaller = values1.size() <= values2.size() ? values1 : values2;
+    const auto& larger = values1.size() <= values2.size() ? values2 : values1;
+    const T* position = larger.data();
+    const T* end = larger.data() + larger.size();
+    for (T value : smaller) {
+        position = gallop(position, end, value);
+        if (position == end) {
+            break;
+        }
+        if (*position == value) {
+            result.push_back(value);
+        }
+    }
+}
+
+template<typename T>
+void differenceGalloping(const std::vector<T>& values1, const std::vector<T>& values2, std::vector<T>& result) noexcept {
+    if (values1.size() <= values2.size()) {
+        const T* position = values2.data();
+        const T* end = values2.data() + values2.size();
+        for (T value : values1) {
+            position = gallop(position, end, value);
+            if (position == end || *position != value) {
+                result.push_back(value);
+            }
+        }
+    } else {
+        // copies the runs of values1 between the values of values2 that it contains
+        const T* copied = values1.data();
+        const T* end = values1.data() + values1.size();
+        for (T value : values2) {
+            const T* position = gallop(copied, end, value);
+            result.insert(result.end(), copied, position);
+            copied = position;
+            if (position == end) {
+                break;
+            }
+            if (*position == value) {
+                ++copied;
+            }
+        }
+        result.insert(result.end(), copied, end);
+    }
+}
+
+// the implementations each kernel can use, from the least to the most capable processor they need
+enum class KernelLevel {
+    SCALAR,
+    SSE4_2,
+    AVX2
+};
+
+// the most capable implementation the running processor supports, which the kernels use unless told otherwise
+KernelLevel supportedKernelLevel() noexcept;
+// makes every kernel use the implementation of level from then on, which the running processor has to support,
+// so that the tests and benchmarks can compare each implementation against the others
+void useKernelLevel(KernelLevel level) noexcept;
+
+void intersectSorted(const std::vector<ElementId>& elements1, const std::vector<ElementId>& elements2, std::vector<ElementId>& result) noexcept;
+void uniteSorted(const std::vector<ElementId>& elements1, const std::vector<ElementId>& elements2, std::vector<ElementId>& result) noexcept;
+void differenceSorted(const std::vector<ElementId>& elements1, const std::vector<ElementId>& elements2, std::vector<ElementId>& result) noexcept;
+void symmetricDifferenceSorted(const std::vector<ElementId>& elements1, const std::vector<ElementId>& elements2, std::vector<ElementId>& result) noexcept;
\ No newline at end of file
@@ -0,0 +1,521 @@
+/*
+    element-set.cpp
+
+    ElementSet is the storage type every UserSet keeps its elements and complement elements in
+    Elements are stored as the ElementIds handed out by the ElementDictionary of the hierarchy, rather than as their strings
+
+    Each set picks its own layout from its cardinality and density whenever it is built or optimized:
+    small or sparse sets are a single sorted array of ids,
+    every other set is laid out as a compressed (Roaring) bitmap, with ids split by their high 16 bits into chunks that are each held in an ElementContainer
+    (a sorted array, a dense bitmap, or runs), so that set operations are done chunk by chunk as merges of small arrays or word-wise AND/OR/ANDNOT/XOR of bitmaps
+    Sets that are both single arrays are merged by the vectorized kernels of element-kernels.hpp
+    The chunks themselves are kept in a contiguous vector sorted by their high bits, results are appended to it in order and lookups binary search it
+*/
+#include "element-set.hpp"
+#include "element-kernels.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <tuple>
+
+namespace {
+    uint16_t highBits(ElementId element) {
+        return element >> 16;
+    }
+
+    uint16_t lowBits(ElementId element) {
+        return element & 0xFFFF;
+    }
+}
+
+
+ElementSet::ElementSet(std::vector<ElementId> elements) noexcept
+    : array_(std::move(elements))
+{
+    std::sort(array_.begin(), array_.end());
+    array_.erase(std::unique(array_.begin(), array_.end()), array_.end());
+    optimize();
+}
+
+ElementSet::Chunks::iterator ElementSet::findChunk(uint16_t key) noexcept {
+    return std::lower_bound(chunks_.begin(), chunks_.end(), key, [](const Chunk& chunk, uint16_t key) {
+        return chunk.key < key;
+    });
+}
+
+ElementSet::Chunks::const_iterator ElementSet::findChunk(uint16_t key) const noexcept {
+    return std::lower_bound(chunks_.begin(), chunks_.end(), key, [](const Chunk& chunk, uint16_t key) {
+        return chunk.key < key;
+    });
+}
+
+bool ElementSet::insert(ElementId element) noexcept {
+    if (!chunked_) {
+        auto elementIt = std::lower_bound(array_.begin(), array_.end(), element);
+        if (elementIt != array_.end() && *elementIt == element) {
+            return false;
+        }
+        array_.insert(elementIt, element);
+        if (array_.size() > ARRAY_MAX_CARDINALITY) {
+            toChunks();
+        }
+        return true;
+    }
+
+    auto chunkIt = findChunk(highBits(element));
+    if (chunkIt == chunks_.end() || chunkIt->key != highBits(element)) {
+        chunkIt = chunks_.insert(chunkIt, Chunk{highBits(element), ElementContainer()});
+    }
+    return chunkIt->container.insert(lowBits(element));
+}
+
+bool ElementSet::erase(ElementId element) noexcept {
+    if (!chunked_) {
+        auto elementIt = std::lower_bound(array_.begin(), array_.end(), element);
+        if (elementIt == array_.end() || *elementIt != element) {
+            return false;
+        }
+        array_.erase(elementIt);
+        return true;
+    }
+
+    auto chunkIt = findChunk(highBits(element));
+    if (chunkIt == chunks_.end() || chunkIt->key != highBits(element) || !chunkIt->container.erase(lowBits(element))) {
+        return false;
+    }
+    if (chunkIt->container.empty()) {
+        chunks_.erase(chunkIt);
+    }
+    return true;
+}
+
+bool ElementSet::contains(ElementId element) const noexcept {
+    if (!chunked_) {
+        return std::binary_search(array_.begin(), array_.end(), element);
+    }
+    auto chunkIt = findChunk(highBits(element));
+    return chunkIt != chunks_.end() && chunkIt->key == highBits(element) && chunkIt->container.contains(lowBits(element));
+}
+
+size_t ElementSet::size() const noexcept {
+    if (!chunked_) {
+        return array_.size();
+    }
+    size_t size = 0;
+    for (const auto& chunk : chunks_) {
+        size += chunk.container.cardinality();
+    }
+    return size;
+}
+
+bool ElementSet::empty() const noexcept {
+    return chunked_ ? chunks_.empty() : array_.empty();
+}
+
+void ElementSet::clear() noexcept {
+    chunked_ = false;
+    array_.clear();
+    chunks_.clear();
+}
+
+ElementSet::const_iterator ElementSet::begin() const noexcept {
+    return const_iterator(this, 0);
+}
+
+ElementSet::const_iterator ElementSet::end() const noexcept {
+    return const_iterator(this, chunked_ ? chunks_.size() : array_.size());
+}
+
+bool ElementSet::chunked() const noexcept {
+    return chunked_;
+}
+
+size_t ElementSet::chunkedSizeInBytes() const noexcept {
+    size_t size = 0;
+    if (chunked_) {
+        for (const auto& chunk : chunks_) {
+            size += sizeof(Chunk) + chunk.container.sizeInBytes();
+        }
+        return size;
+    }
+
+    // estimates what the chunks would take if they were built from the array as arrays or bitmaps
+    auto elementIt = array_.begin();
+    while (elementIt != array_.end()) {
+        auto chunkEnd = std::upper_bound(elementIt, array_.end(), *elementIt | 0xFFFF);
+        size_t cardinality = chunkEnd - elementIt;
+        size += sizeof(Chunk) + std::min(cardinality * sizeof(uint16_t), size_t(ElementContainer::BITMAP_WORDS * sizeof(uint64_t)));
+        elementIt = chunkEnd;
+    }
+    return size;
+}
+
+void ElementSet::optimize() noexcept {
+    size_t cardinality = size();
+    if (cardinality <= ARRAY_MAX_CARDINALITY && cardinality * sizeof(ElementId) <= chunkedSizeInBytes()) {
+        toArray();
+        return;
+    }
+
+    toChunks();
+    for (auto& chunk : chunks_) {
+        chunk.container.optimize();
+    }
+}
+
+void ElementSet::toChunks() noexcept {
+    if (chunked_) {
+        return;
+    }
+
+    auto elementIt = array_.begin();
+    while (elementIt != array_.end()) {
+        uint16_t key = highBits(*elementIt);
+        std::vector<uint16_t> values;
+        for (; elementIt != array_.end() && highBits(*elementIt) == key; ++elementIt) {
+            values.push_back(lowBits(*elementIt));
+        }
+        chunks_.push_back(Chunk{key, ElementContainer(std::move(values))});
+    }
+    array_ = std::vector<ElementId>();
+    chunked_ = true;
+}
+
+void ElementSet::toArray() noexcept {
+    if (!chunked_) {
+        return;
+    }
+
+    std::vector<ElementId> elements;
+    elements.reserve(size());
+    elements.assign(begin(), end());
+    array_ = std::move(elements);
+    chunks_ = Chunks();
+    chunked_ = false;
+}
+
+ElementSet ElementSet::intersect(const ElementSet& set1, const ElementSet& set2) noexcept {
+    ElementSet result;
+    if (!set1.chunked_ && !set2.chunked_) {
+        intersectSorted(set1.array_, set2.array_, result.array_);
+    } else if (!set1.chunked_ || !set2.chunked_) {
+        // an intersection is never larger than its array operand, so only its elements need probing
+        const auto& arraySet = set1.chunked_ ? set2 : set1;
+        const auto& chunkedSet = set1.chunked_ ? set1 : set2;
+        result.array_.reserve(arraySet.array_.size());
+        for (auto element : arraySet.array_) {
+            if (chunkedSet.contains(element)) {
+                result.array_.push_back(element);
+            }
+        }
+    } else {
+        result = intersectChunks(set1, set2);
+    }
+    result.optimize();
+    return result;
+}
+
+ElementSet ElementSet::unite(const ElementSet& set1, const ElementSet& set2) noexcept {
+    ElementSet result;
+    if (!set1.chunked_ && !set2.chunked_) {
+        uniteSorted(set1.array_, set2.array_, result.array_);
+    } else if (!set1.chunked_ || !set2.chunked_) {
+        const auto& arraySet = set1.chunked_ ? set2 : set1;
+        result = set1.chunked_ ? set1 : set2;
+        for (auto element : arraySet.array_) {
+            result.insert(element);
+        }
+    } else {
+        result = uniteChunks(set1, set2);
+    }
+    result.optimize();
+    return result;
+}
+
+ElementSet ElementSet::difference(const ElementSet& set1, const ElementSet& set2) noexcept {
+    ElementSet result;
+    if (!set1.chunked_ && !set2.chunked_) {
+        differenceSorted(set1.array_, set2.array_, result.array_);
+    } else if (!set1.chunked_) {
+        result.array_.reserve(set1.array_.size());
+        for (auto element : set1.array_) {
+            if (!set2.contains(element)) {
+                result.array_.push_back(element);
+            }
+        }
+    } else if (!set2.chunked_) {
+        result = set1;
+        for (auto element : set2.array_) {
+            result.erase(element);
+        }
+    } else {
+        result = differenceChunks(set1, set2);
+    }
+    result.optimize();
+    return result;
+}
+
+ElementSet ElementSet::symmetricDifference(const ElementSet& set1, const ElementSet& set2) noexcept {
+    ElementSet result;
+    if (!set1.chunked_ && !set2.chunked_) {
+        symmetricDifferenceSorted(set1.array_, set2.array_, result.array_);
+    } else if (!set1.chunked_ || !set2.chunked_) {
+        const auto& arraySet = set1.chunked_ ? set2 : set1;
+        result = set1.chunked_ ? set1 : set2;
+        for (auto element : arraySet.array_) {
+            if (!result.erase(element)) {
+                result.insert(element);
+            }
+        }
+    } else {
+        result = symmetricDifferenceChunks(set1, set2);
+    }
+    result.optimize();
+    return result;
+}
+
+ElementSet ElementSet::intersect(const std::vector<const ElementSet*>& sets) noexcept {
+    if (sets.empty()) {
+        return ElementSet();
+    }
+    if (sets.size() == 1) {
+        return *sets.front();
+    }
+
+    // the smallest sets narrow the result down the fastest, and every later intersection is done against that narrowed result
+    std::vector<const ElementSet*> bySize = sets;
+    std::sort(bySize.begin(), bySize.end(), [](const ElementSet* set1, const ElementSet* set2) {
+        return set1->size() < set2->size();
+    });
+    ElementSet result = intersect(*bySize[0], *bySize[1]);
+    for (size_t i = 2; i < bySize.size() && !result.empty(); ++i) {
+        result = intersect(result, *bySize[i]);
+    }
+    return result;
+}
+
+ElementSet ElementSet::intersectExcluding(const std::vector<const ElementSet*>& included, const std::vector<const ElementSet*>& excluded) noexcept {
+    if (included.empty()) {
+        return ElementSet();
+    }
+
+    std::vector<const ElementSet*> bySize = included;
+    std::sort(bySize.begin(), bySize.end(), [](const ElementSet* set1, const ElementSet* set2) {
+        return set1->size() < set2->size();
+    });
+    const auto& smallest = *bySize.front();
+    if (!smallest.chunked_) {
+        // the result can only hold elements of the smallest set, so a single pass probing every other set with them builds it directly
+        ElementSet result;
+        result.array_.reserve(smallest.array_.size());
+        for (auto element : smallest.array_) {
+            bool kept = std::all_of(bySize.begin() + 1, bySize.end(), [element](const ElementSet* set) {
+                return set->contains(element);
+            }) && std::none_of(excluded.begin(), excluded.end(), [element](const ElementSet* set) {
+                return set->contains(element);
+            });
+            if (kept) {
+                result.array_.push_back(element);
+            }
+        }
+        result.optimize();
+        return result;
+    }
+
+    // chunked sets are combined a chunk at a time, removing each excluded set from the narrowed result rather than uniting them first
+    ElementSet result = intersect(bySize);
+    for (size_t i = 0; i < excluded.size() && !result.empty(); ++i) {
+        result = difference(result, *excluded[i]);
+    }
+    return result;
+}
+
+ElementSet ElementSet::unite(const std::vector<const ElementSet*>& sets) noexcept {
+    // array sets are chunked into copies so that every set can be merged chunk by chunk
+    std::vector<ElementSet> chunkedCopies;
+    chunkedCopies.reserve(sets.size());
+    std::vector<const ElementSet*> chunkedSets;
+    chunkedSets.reserve(sets.size());
+    for (const auto* set : sets) {
+        if (set->chunked_) {
+            chunkedSets.push_back(set);
+        } else if (!set->empty()) {
+            chunkedCopies.push_back(*set);
+            chunkedCopies.back().toChunks();
+            chunkedSets.push_back(&chunkedCopies.back());
+        }
+    }
+
+    // a min-heap of the next chunk key of every set that still has chunks left, paired with the set and the chunk index
+    typedef std::tuple<uint16_t, size_t, size_t> HeapEntry;
+    std::vector<HeapEntry> heap;
+    heap.reserve(chunkedSets.size());
+    for (size_t i = 0; i < chunkedSets.size(); ++i) {
+        if (!chunkedSets[i]->chunks_.empty()) {
+            heap.emplace_back(chunkedSets[i]->chunks_.front().key, i, 0);
+        }
+    }
+    std::make_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+
+    ElementSet result;
+    result.chunked_ = true;
+    std::vector<const ElementContainer*> containers;
+    containers.reserve(chunkedSets.size());
+    while (!heap.empty()) {
+        uint16_t key = std::get<0>(heap.front());
+        containers.clear();
+        // pops every chunk sharing the lowest key, queueing the chunk after each of them
+        while (!heap.empty() && std::get<0>(heap.front()) == key) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+            auto [chunkKey, i, chunkIndex] = heap.back();
+            heap.pop_back();
+            const auto& chunks = chunkedSets[i]->chunks_;
+            containers.push_back(&chunks[chunkIndex].container);
+            if (chunkIndex + 1 < chunks.size()) {
+                heap.emplace_back(chunks[chunkIndex + 1].key, i, chunkIndex + 1);
+                std::push_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+            }
+        }
+        if (containers.size() == 1) {
+            result.chunks_.push_back(Chunk{key, *containers.front()});
+        } else {
+            result.chunks_.push_back(Chunk{key, ElementContainer::unite(containers)});
+        }
+    }
+    result.optimize();
+    return result;
+}
+
+ElementSet ElementSet::intersectChunks(const ElementSet& set1, const ElementSet& set2) noexcept {
+    ElementSet result;
+    result.chunked_ = true;
+    result.chunks_.reserve(std::min(set1.chunks_.size(), set2.chunks_.size()));
+    auto chunk1It = set1.chunks_.begin();
+    auto chunk2It = set2.chunks_.begin();
+    while (chunk1It != set1.chunks_.end() && chunk2It != set2.chunks_.end()) {
+        if (chunk1It->key < chunk2It->key) {
+            ++chunk1It;
+        } else if (chunk2It->key < chunk1It->key) {
+            ++chunk2It;
+        } else {
+            auto container = ElementContainer::intersect(chunk1It->container, chunk2It->container);
+            if (!container.empty()) {
+                result.chunks_.push_back(Chunk{chunk1It->key, std::move(container)});
+            }
+            ++chunk1It;
+            ++chunk2It;
+        }
+    }
+    return result;
+}
+
+ElementSet ElementSet::uniteChunks(const ElementSet& set1, const ElementSet& set2) noexcept {
+    ElementSet result;
+    result.chunked_ = true;
+    result.chunks_.reserve(set1.chunks_.size() + set2.chunks_.size());
+    auto chunk1It = set1.chunks_.begin();
+    auto chunk2It = set2.chunks_.begin();
+    while (chunk1It != set1.chunks_.end() || chunk2It != set2.chunks_.end()) {
+        if (chunk2It == set2.chunks_.end() || (chunk1It != set1.chunks_.end() && chunk1It->key < chunk2It->key)) {
+            result.chunks_.push_back(*chunk1It);
+            ++chunk1It;
+        } else if (chunk1It == set1.chunks_.end() || chunk2It->key < chunk1It->key) {
+            result.chunks_.push_back(*chunk2It);
+            ++chunk2It;
+        } else {
+            auto container = ElementContainer::unite(chunk1It->container, chunk2It->container);
+            result.chunks_.push_back(Chunk{chunk1It->key, std::move(container)});
+            ++chunk1It;
+            ++chunk2It;
+        }
+    }
+    return result;
+}
+
+ElementSet ElementSet::differenceChunks(const ElementSet& set1, const ElementSet& set2) noexcept {
+    ElementSet result;
+    result.chunked_ = true;
+    result.chunks_.reserve(set1.chunks_.size());
+    auto chunk2It = set2.chunks_.begin();
+    for (const auto& chunk1 : set1.chunks_) {
+        while (chunk2It != set2.chunks_.end() && chunk2It->key < chunk1.key) {
+            ++chunk2It;
+        }
+        if (chunk2It == set2.chunks_.end() || chunk2It->key != chunk1.key) {
+            result.chunks_.push_back(chunk1);
+            continue;
+        }
+        auto container = ElementContainer::difference(chunk1.container, chunk2It->container);
+        if (!container.empty()) {
+            result.chunks_.push_back(Chunk{chunk1.key, std::move(container)});
+        }
+    }
+    return result;
+}
+
+ElementSet ElementSet::symmetricDifferenceChunks(const ElementSet& set1, const ElementSet& set2) noexcept {
+    ElementSet result;
+    result.chunked_ = true;
+    result.chunks_.reserve(set1.chunks_.size() + set2.chunks_.size());
+    auto chunk1It = set1.chunks_.begin();
+    auto chunk2It = set2.chunks_.begin();
+    while (chunk1It != set1.chunks_.end() || chunk2It != set2.chunks_.end()) {
+        if (chunk2It == set2.chunks_.end() || (chunk1It != set1.chunks_.end() && chunk1It->key < chunk2It->key)) {
+            result.chunks_.push_back(*chunk1It);
+            ++chunk1It;
+        } else if (chunk1It == set1.chunks_.end() || chunk2It->key < chunk1It->key) {
+            result.chunks_.push_back(*chunk2It);
+            ++chunk2It;
+        } else {
+            auto container = ElementContainer::symmetricDifference(chunk1It->container, chunk2It->container);
+            if (!container.empty()) {
+                result.chunks_.push_back(Chunk{chunk1It->key, std::move(container)});
+            }
+            ++chunk1It;
+            ++chunk2It;
+        }
+    }
+    return result;
+}
+
+ElementSet::const_iterator::const_iterator(const ElementSet* set, size_t index) noexcept
+    : set_(set), index_(index)
+{
+    if (set_->chunked_ && index_ != set_->chunks_.size()) {
+        cursor_ = set_->chunks_[index_].container.first();
+    }
+}
+
+ElementId ElementSet::const_iterator::operator*() const noexcept {
+    if (!set_->chunked_) {
+        return set_->array_[index_];
+    }
+    const auto& chunk = set_->chunks_[index_];
+    return (ElementId(chunk.key) << 16) | chunk.container.value(cursor_);
+}
+
+ElementSet::const_iterator& ElementSet::const_iterator::operator++() noexcept {
+    if (!set_->chunked_) {
+        ++index_;
+        return *this;
+    }
+
+    const auto& container = set_->chunks_[index_].container;
+    container.next(cursor_);
+    // chunks are never empty, so an exhausted chunk always has a first element in the next one
+    if (container.atEnd(cursor_)) {
+        ++index_;
+        cursor_ = index_ != set_->chunks_.size() ? set_->chunks_[index_].container.first() : ElementContainer::Cursor{0, 0};
+    }
+    return *this;
+}
+
+ElementSet::const_iterator ElementSet::const_iterator::operator++(int) noexcept {
+    auto previous = *this;
+    ++*this;
+    return previous;
+}
+
+bool ElementSet::const_iterator::operator==(const const_iterator& other) const noexcept {
+    return index_ == other.index_ && cursor_ == other.cursor_;
+}
\ No newline at end of file
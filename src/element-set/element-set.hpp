@@ -0,0 +1,111 @@
+/*
+    element-set.hpp
+
+    ElementSet is the storage type every UserSet keeps its elements and complement elements in
+    Elements are stored as the ElementIds handed out by the ElementDictionary of the hierarchy, rather than as their strings
+
+    Each set picks its own layout from its cardinality and density whenever it is built or optimized:
+    small or sparse sets are a single sorted array of ids,
+    every other set is laid out as a compressed (Roaring) bitmap, with ids split by their high 16 bits into chunks that are each held in an ElementContainer
+    (a sorted array, a dense bitmap, or runs), so that set operations are done chunk by chunk as merges of small arrays or word-wise AND/OR/ANDNOT/XOR of bitmaps
+    The chunks themselves are kept in a contiguous vector sorted by their high bits, results are appended to it in order and lookups binary search it
+*/
+#pragma once
+
+#include "element-container.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+typedef uint32_t ElementId;
+
+class ElementSet {
+    public:
+        class const_iterator;
+
+        ElementSet() noexcept = default;
+        // builds the set from elements in any order, with a single pass over them once they are sorted
+        explicit ElementSet(std::vector<ElementId> elements) noexcept;
+
+        bool insert(ElementId element) noexcept;
+        bool erase(ElementId element) noexcept;
+        bool contains(ElementId element) const noexcept;
+        size_t size() const noexcept;
+        bool empty() const noexcept;
+        void clear() noexcept;
+
+        const_iterator begin() const noexcept;
+        const_iterator end() const noexcept;
+
+        // returns whether the set is currently laid out in chunks rather than as a single sorted array
+        bool chunked() const noexcept;
+        // picks whichever layout takes the least memory for the set, and converts every chunk to its smallest container layout
+        void optimize() noexcept;
+
+        static ElementSet intersect(const ElementSet& set1, const ElementSet& set2) noexcept;
+        static ElementSet unite(const ElementSet& set1, const ElementSet& set2) noexcept;
+        static ElementSet difference(const ElementSet& set1, const ElementSet& set2) noexcept;
+        static ElementSet symmetricDifference(const ElementSet& set1, const ElementSet& set2) noexcept;
+        // combine any number of sets at once, rather than building every intermediate set of combining them two at a time
+        static ElementSet intersect(const std::vector<const ElementSet*>& sets) noexcept;
+        static ElementSet unite(const std::vector<const ElementSet*>& sets) noexcept;
+        // the elements of every included set that are in none of the excluded sets, computed without building the intersection or union first
+        static ElementSet intersectExcluding(const std::vector<const ElementSet*>& included, const std::vector<const ElementSet*>& excluded) noexcept;
+
+        // a sorted array larger than this is always chunked, so that inserting into it stays cheap
+        static constexpr size_t ARRAY_MAX_CARDINALITY = 4096;
+    private:
+        struct Chunk {
+            uint16_t key;
+            ElementContainer container;
+        };
+        typedef std::vector<Chunk> Chunks;
+
+        Chunks::iterator findChunk(uint16_t key) noexcept;
+        Chunks::const_iterator findChunk(uint16_t key) const noexcept;
+
+        // the number of bytes the set takes, or would take, when laid out in chunks
+        size_t chunkedSizeInBytes() const noexcept;
+        void toChunks() noexcept;
+        void toArray() noexcept;
+
+        static ElementSet intersectChunks(const ElementSet& set1, const ElementSet& set2) noexcept;
+        static ElementSet uniteChunks(const ElementSet& set1, const ElementSet& set2) noexcept;
+        static ElementSet differenceChunks(const ElementSet& set1, const ElementSet& set2) noexcept;
+        static ElementSet symmetricDifferenceChunks(const ElementSet& set1, const ElementSet& set2) noexcept;
+
+        bool chunked_ = false;
+        // holds the elements while the set is not chunked
+        std::vector<ElementId> array_;
+        // holds the elements while the set is chunked
+        Chunks chunks_;
+
+        friend class const_iterator;
+};
+
+class ElementSet::const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = ElementId;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const ElementId*;
+        using reference = ElementId;
+
+        const_iterator() noexcept = default;
+
+        ElementId operator*() const noexcept;
+        const_iterator& operator++() noexcept;
+        const_iterator operator++(int) noexcept;
+        bool operator==(const const_iterator& other) const noexcept;
+    private:
+        const_iterator(const ElementSet* set, size_t index) noexcept;
+
+        const ElementSet* set_ = nullptr;
+        // the position in the array of an unchunked set, or the chunk of a chunked set
+        size_t index_ = 0;
+        ElementContainer::Cursor cursor_ = {0, 0};
+
+        friend class ElementSet;
+};
\ No newline at end of file
@@ -0,0 +1,53 @@
+/*
+    set-algebra.cpp
+
+    The set algebra every derivative set computes its elements with
+    A set is either finite, and stores its elements, or infinite (complemented), and stores the elements it lacks instead
+    Each operation is specialized at compile time for all four combinations of finite and infinite operands,
+    where the identities below reduce it to a single ElementSet operation on the stored elements, so callers never branch on the combination
+*/
+#include "set-algebra.hpp"
+
+namespace {
+    // splits the stored elements of sets by whether they are complemented
+    void partition(const std::vector<SetView>& sets, std::vector<const ElementSet*>& finiteStored, std::vector<const ElementSet*>& complementedStored) {
+        for (const auto& set : sets) {
+            (set.complemented ? complementedStored : finiteStored).push_back(set.stored);
+        }
+    }
+}
+
+SetValue intersectSets(const std::vector<SetView>& sets) noexcept {
+    std::vector<const ElementSet*> finiteStored;
+    std::vector<const ElementSet*> complementedStored;
+    partition(sets, finiteStored, complementedStored);
+
+    if (finiteStored.empty()) {
+        // https://proofwiki.org/wiki/De_Morgan%27s_Laws_(Set_Theory)/Set_Complement/Complement_of_Intersection
+        // ~(A Intersect B) = ~A Union ~B
+        return {true, ElementSet::unite(complementedStored)};
+    }
+    // https://proofwiki.org/wiki/Set_Difference_as_Intersection_with_Complement
+    // A Difference B = A Intersect ~B
+    // => A Difference ~B = A Intersect B
+    // => (A1 Intersect ... Intersect An) Difference (~B1 Union ... Union ~Bm) = A1 Intersect ... Intersect An Intersect B1 Intersect ... Intersect Bm
+    // where every A is finite and every B is infinite
+    return {false, ElementSet::intersectExcluding(finiteStored, complementedStored)};
+}
+
+SetValue uniteSets(const std::vector<SetView>& sets) noexcept {
+    std::vector<const ElementSet*> finiteStored;
+    std::vector<const ElementSet*> complementedStored;
+    partition(sets, finiteStored, complementedStored);
+
+    if (complementedStored.empty()) {
+        return {false, ElementSet::unite(finiteStored)};
+    }
+    // https://proofwiki.org/wiki/De_Morgan%27s_Laws_(Set_Theory)/Set_Complement/Complement_of_Union
+    // ~(A Union B) = ~A Intersect ~B
+    // https://proofwiki.org/wiki/Set_Difference_as_Intersection_with_Complement
+    // A Difference B = A Intersect ~B
+    // => ~(A1 Union ... Union An Union B1 Union ... Union Bm) = (~A1 Intersect ... Intersect ~An) Difference (B1 Union ... Union Bm)
+    // where every A is infinite and every B is finite
+    return {true, ElementSet::intersectExcluding(complementedStored, finiteStored)};
+}
\ No newline at end of file
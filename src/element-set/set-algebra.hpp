@@ -0,0 +1,126 @@
+/*
+    set-algebra.hpp
+
+    The set algebra every derivative set computes its elements with
+    A set is either finite, and stores its elements, or infinite (complemented), and stores the elements it lacks instead
+    Each operation is specialized at compile time for all four combinations of finite and infinite operands,
+    where the identities below reduce it to a single ElementSet operation on the stored elements, so callers never branch on the combination
+*/
+#pragma once
+
+#include "element-set.hpp"
+
+#include <vector>
+
+enum class SetOperation {
+    INTERSECT,
+    UNITE,
+    DIFFERENCE,
+    SYMMETRIC_DIFFERENCE
+};
+
+// a set whose stored elements are owned elsewhere
+struct SetView {
+    // whether stored holds the elements the set lacks, rather than the elements it has
+    bool complemented;
+    const ElementSet* stored;
+};
+
+struct SetValue {
+    // whether stored holds the elements the set lacks, rather than the elements it has
+    bool complemented;
+    ElementSet stored;
+};
+
+// stored1 and stored2 are the stored elements of the operands, A and B below, which are the complements of what they store when complemented
+template <SetOperation Operation, bool Complemented1, bool Complemented2>
+SetValue applySetOperation(const ElementSet& stored1, const ElementSet& stored2) noexcept {
+    if constexpr (Operation == SetOperation::INTERSECT) {
+        if constexpr (!Complemented1 && !Complemented2) {
+            return {false, ElementSet::intersect(stored1, stored2)};
+        } else if constexpr (!Complemented1) {
+            // https://proofwiki.org/wiki/Set_Difference_as_Intersection_with_Complement
+            // A Difference B = A Intersect ~B
+            // => A Difference ~B = A Intersect B
+            return {false, ElementSet::difference(stored1, stored2)};
+        } else if constexpr (!Complemented2) {
+            // same logic as prior case, but in reverse
+            return {false, ElementSet::difference(stored2, stored1)};
+        } else {
+            // https://proofwiki.org/wiki/De_Morgan%27s_Laws_(Set_Theory)/Set_Complement/Complement_of_Intersection
+            // ~(A Intersect B) = ~A Union ~B
+            return {true, ElementSet::unite(stored1, stored2)};
+        }
+    } else if constexpr (Operation == SetOperation::UNITE) {
+        if constexpr (!Complemented1 && !Complemented2) {
+            return {false, ElementSet::unite(stored1, stored2)};
+        } else if constexpr (!Complemented1) {
+            // https://proofwiki.org/wiki/De_Morgan%27s_Laws_(Set_Theory)/Set_Complement/Complement_of_Union
+            // ~(A Union B) = ~A Intersect ~B
+            // https://proofwiki.org/wiki/Set_Difference_as_Intersection_with_Complement
+            // A Difference B = A Intersect ~B
+            // => ~(A Union B) = ~B Difference A
+            return {true, ElementSet::difference(stored2, stored1)};
+        } else if constexpr (!Complemented2) {
+            // same logic as prior case, but in reverse
+            return {true, ElementSet::difference(stored1, stored2)};
+        } else {
+            // https://proofwiki.org/wiki/De_Morgan%27s_Laws_(Set_Theory)/Set_Complement/Complement_of_Union
+            // ~(A Union B) = ~A Intersect ~B
+            return {true, ElementSet::intersect(stored1, stored2)};
+        }
+    } else if constexpr (Operation == SetOperation::DIFFERENCE) {
+        if constexpr (!Complemented1 && !Complemented2) {
+            return {false, ElementSet::difference(stored1, stored2)};
+        } else if constexpr (!Complemented1) {
+            // https://proofwiki.org/wiki/Set_Difference_as_Intersection_with_Complement
+            // A Difference B = A Intersect ~B
+            // => A Difference ~B = A Intersect B
+            return {false, ElementSet::intersect(stored1, stored2)};
+        } else if constexpr (!Complemented2) {
+            // infinite - finite is the only infinite difference
+            // https://proofwiki.org/wiki/Set_Difference_as_Intersection_with_Complement
+            // A Difference B = A Intersect ~B
+            // https://proofwiki.org/wiki/De_Morgan%27s_Laws_(Set_Theory)/Set_Complement/Complement_of_Intersection
+            // ~(A Intersect B) = ~A Union ~B
+            // => ~(A Difference B) = ~A Union B
+            return {true, ElementSet::unite(stored1, stored2)};
+        } else {
+            // https://proofwiki.org/wiki/Set_Difference_of_Complements
+            // ~B Difference ~A = A Difference B
+            return {false, ElementSet::difference(stored2, stored1)};
+        }
+    } else {
+        if constexpr (!Complemented1 && !Complemented2) {
+            return {false, ElementSet::symmetricDifference(stored1, stored2)};
+        } else if constexpr (Complemented1 && Complemented2) {
+            // https://proofwiki.org/wiki/Symmetric_Difference_of_Complements
+            // ~A SymmetricDifference ~B = A SymmetricDifference B
+            return {false, ElementSet::symmetricDifference(stored1, stored2)};
+        } else {
+            // https://proofwiki.org/wiki/Category:Symmetric_Difference Definition 3
+            // A SymmetricDifference B = (A Intersect ~B) Union (~A Intersect B)
+            // so complementing either operand complements the result
+            // => ~(~A SymmetricDifference B) = A SymmetricDifference B
+            return {true, ElementSet::symmetricDifference(stored1, stored2)};
+        }
+    }
+}
+
+template <SetOperation Operation>
+SetValue applySetOperation(const SetView& set1, const SetView& set2) noexcept {
+    if (set1.complemented) {
+        if (set2.complemented) {
+            return applySetOperation<Operation, true, true>(*set1.stored, *set2.stored);
+        }
+        return applySetOperation<Operation, true, false>(*set1.stored, *set2.stored);
+    }
+    if (set2.complemented) {
+        return applySetOperation<Operation, false, true>(*set1.stored, *set2.stored);
+    }
+    return applySetOperation<Operation, false, false>(*set1.stored, *set2.stored);
+}
+
+// intersect or unite any number of sets at once
+SetValue intersectSets(const std::vector<SetView>& sets) noexcept;
+SetValue uniteSets(const std::vector<SetView>& sets) noexcept;
\ No newline at end of file
@@ -5,6 +5,9 @@
 */
 #include "helpers.hpp"
 
+#include <nowide/iostream.hpp>
+
+#include <cstdlib>
 #include <stack>
 #include <iomanip>
 #include <memory>
@@ -45,4 +48,9 @@ void skipRead(std::istream& istr, size_t count) {
 
 void ignoreAll(std::istream& istr) {
     istr.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+}
+
+void exitWithoutSaving() {
+    nowide::cout.flush();
+    std::quick_exit(0);
 }
\ No newline at end of file
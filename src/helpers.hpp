@@ -25,4 +25,7 @@ bool insensitiveSame(std::string_view str1, std::string_view str2);
 
 void skipRead(std::istream& istr, size_t count);
 
-void ignoreAll(std::istream& istr);
\ No newline at end of file
+void ignoreAll(std::istream& istr);
+
+// exits the program without saving or destroying anything, as the sets may still be in use by the other threads of the pool when it is chosen from inside of a task they run
+[[noreturn]] void exitWithoutSaving();
\ No newline at end of file
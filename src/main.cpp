@@ -7,10 +7,12 @@
 GlobalSet GLOBAL_SET;
 
 int main() {
-    // load from default machine location if it exists
-    if (std::filesystem::exists(UserSet::DEFAULT_MACHINE_LOCATION)) {
-        nowide::ifstream defaultMachineLocation(denativePath(UserSet::DEFAULT_MACHINE_LOCATION));
-        GLOBAL_SET.loadMachineSubsets(defaultMachineLocation);
+    // load from default machine location if it exists, or from where it was saved as text before otherwise
+    for (const auto& machineLocation : {UserSet::DEFAULT_MACHINE_LOCATION, UserSet::DEFAULT_TEXT_MACHINE_LOCATION}) {
+        if (std::filesystem::exists(machineLocation)) {
+            GLOBAL_SET.loadMachineSubsets(machineLocation);
+            break;
+        }
     }
     while (GLOBAL_SET.query());
     // exit with the intended exit dialogue
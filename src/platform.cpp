@@ -19,10 +19,31 @@ nstring nativeString(std::string_view utf8String) {
     return nativeString;
 }
 
+void syncFile(const std::filesystem::path& path) noexcept {
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    FlushFileBuffers(file);
+    CloseHandle(file);
+}
+
+// a file that is mapped cannot be replaced on windows, which saving over the file loaded from has to do, so it is read instead
+MappedFile::MappedFile(const std::filesystem::path&) noexcept {
+}
+
+MappedFile::~MappedFile() noexcept {
+}
+
 #endif
 
 #ifdef linux
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 std::string denativePath(const std::filesystem::path& path) {
     return std::string(reinterpret_cast<const char*>(path.u8string().data()));
 }
@@ -34,4 +55,44 @@ nstring nativeString(std::string_view utf8String) {
     return nstring(utf8String);
 }
 
-#endif
\ No newline at end of file
+void syncFile(const std::filesystem::path& path) noexcept {
+    int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) {
+        return;
+    }
+    fsync(file);
+    close(file);
+}
+
+MappedFile::MappedFile(const std::filesystem::path& path) noexcept {
+    int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) {
+        return;
+    }
+    struct stat status;
+    if (fstat(file, &status) == 0 && status.st_size > 0) {
+        void* contents = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (contents != MAP_FAILED) {
+            contents_ = static_cast<const char*>(contents);
+            size_ = status.st_size;
+        }
+    }
+    // the mapping keeps the file open by itself
+    close(file);
+}
+
+MappedFile::~MappedFile() noexcept {
+    if (contents_ != nullptr) {
+        munmap(const_cast<char*>(contents_), size_);
+    }
+}
+
+#endif
+
+bool MappedFile::mapped() const noexcept {
+    return contents_ != nullptr;
+}
+
+std::string_view MappedFile::contents() const noexcept {
+    return std::string_view(contents_, size_);
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <filesystem>
 
 #ifdef _WIN32
@@ -20,4 +21,23 @@ typedef std::string_view nstring_view;
 std::string denativePath(const std::filesystem::path& path);
 
 nstring nativeString(const std::string& utf8String);
-nstring nativeString(std::string_view utf8String);
\ No newline at end of file
+nstring nativeString(std::string_view utf8String);
+
+// writes everything written to the file at path through to the disk, so that it is kept if the machine stops before the file is closed
+void syncFile(const std::filesystem::path& path) noexcept;
+
+// a file mapped read-only into memory, whose contents stay valid for as long as it exists
+class MappedFile {
+    public:
+        MappedFile(const std::filesystem::path& path) noexcept;
+        ~MappedFile() noexcept;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // whether the file could be mapped, where it is left unmapped if it is empty, or on platforms it is not mapped on
+        bool mapped() const noexcept;
+        std::string_view contents() const noexcept;
+    private:
+        const char* contents_ = nullptr;
+        size_t size_ = 0;
+};
\ No newline at end of file
@@ -11,24 +11,29 @@
 
 #include "helpers.hpp"
 
-#include <sstream>
+#include <algorithm>
+#include <iterator>
 
 DerivativeSet::DerivativeSet(
     UserSet* parent,
     const std::string& name,
-    std::initializer_list<UserSet*> userSets,
-    std::unique_ptr<std::set<std::string>> elements,
-    std::unique_ptr<std::set<std::string>> complementElements
+    std::vector<UserSet*> userSets,
+    std::unique_ptr<ElementSet> elements,
+    std::unique_ptr<ElementSet> complementElements
 ) noexcept
-    : SubSet(parent, name, std::move(elements), std::move(complementElements)), derivesFrom_(new std::vector<UserSet*>(userSets))
-{}
+    : SubSet(parent, name, std::move(elements), std::move(complementElements)), derivesFrom_(new std::vector<UserSet*>(std::move(userSets)))
+{
+    for (auto* userSet : *derivesFrom_) {
+        userSet->addDependent(this);
+    }
+}
 
 // Note: It is undefined behavior to instantiate this class with the parent, name constructor and then not run postSiblingsLoad() hook
 DerivativeSet::DerivativeSet(
     UserSet* parent,
     const std::string& name,
-    std::unique_ptr<std::set<std::string>> elements,
-    std::unique_ptr<std::set<std::string>> complementElements
+    std::unique_ptr<ElementSet> elements,
+    std::unique_ptr<ElementSet> complementElements
 ) noexcept
     : SubSet(parent, name, std::move(elements), std::move(complementElements)), derivesFromNames_(new std::vector<std::vector<std::string>>)
 {}
@@ -45,47 +50,58 @@ const std::vector<UserSet*>& DerivativeSet::derivesFrom() const noexcept {
     return *derivesFrom_;
 }
 
-void DerivativeSet::saveMachineSubset(std::ostream& saveLocation) noexcept {
-    saveLocation << derivesFrom_->size();
+std::vector<UserSet*> DerivativeSet::queryForSubsets(UserSet& parent) noexcept {
+    std::vector<UserSet*> userSets;
+    while (true) {
+        if (userSets.size() >= 2) {
+            nowide::cout << "Select another subset to include, or exit the subset menu to finish with the " << userSets.size() << " selected\n";
+        }
+        auto* userSet = parent.queryForSubset();
+        if (userSet == nullptr) {
+            if (userSets.size() < 2) {
+                userSets.clear();
+            }
+            return userSets;
+        }
+        userSets.push_back(userSet);
+    }
+}
+
+void DerivativeSet::saveMachineSubset(MachineWriter& saveLocation) noexcept {
+    saveLocation.writeSize(derivesFrom_->size());
     for (const auto* userSet : *derivesFrom_) {
-        std::stringstream nestedSubsetsWrite;
-        int nestedCount = -1;
+        std::vector<const UserSet*> nestedSubsets;
         for (; userSet != parent(); userSet = userSet->parent()) {
-            nestedSubsetsWrite << ' ' << userSet->name().size() << ' ' << userSet->name();
-            ++nestedCount;
+            nestedSubsets.push_back(userSet);
+        }
+        // the count of sets nested within the first one below the parent
+        saveLocation.writeSize(nestedSubsets.size() - 1);
+        for (const auto* nestedSubset : nestedSubsets) {
+            saveLocation.writeString(nestedSubset->name());
         }
-        saveLocation << ' ' << nestedCount << nestedSubsetsWrite.str();
     }
     saveMachineDerivativeSubset(saveLocation);
 }
 
-void DerivativeSet::loadMachineSubset(std::istream& loadLocation) noexcept {
-    int userSetsCount;
-    loadLocation >> userSetsCount;
-    derivesFromNames_->reserve(userSetsCount);
-    for (; userSetsCount > 0; --userSetsCount) {
-        int nestedCount;
-        loadLocation >> nestedCount;
+void DerivativeSet::loadMachineSubset(MachineReader& loadLocation) noexcept {
+    auto userSetsCount = loadLocation.readSize();
+    for (; userSetsCount > 0 && loadLocation.error().empty(); --userSetsCount) {
+        auto nestedCount = loadLocation.readSize();
         std::vector<std::string> userSetNames;
-        userSetNames.resize(nestedCount + 1);
-        for (; nestedCount >= 0; --nestedCount) {
-            int userSetSize;
-            loadLocation >> userSetSize;
-            std::string userSetName;
-            userSetName.resize(userSetSize);
-            skipRead(loadLocation, 1);
-            loadLocation.read(userSetName.data(), userSetSize);
-            userSetNames[nestedCount] = std::move(userSetName);
+        for (size_t nested = 0; nested <= nestedCount && loadLocation.error().empty(); ++nested) {
+            userSetNames.emplace_back(loadLocation.readString());
         }
+        // the names were saved from the set derived from up to the first one below the parent
+        std::reverse(userSetNames.begin(), userSetNames.end());
         derivesFromNames_->push_back(std::move(userSetNames));
     }
     loadMachineDerivativeSubset(loadLocation);
 }
 
-void DerivativeSet::saveMachineDerivativeSubset(std::ostream&) noexcept {
+void DerivativeSet::saveMachineDerivativeSubset(MachineWriter&) noexcept {
 }
 
-void DerivativeSet::loadMachineDerivativeSubset(std::istream&) noexcept {
+void DerivativeSet::loadMachineDerivativeSubset(MachineReader&) noexcept {
 }
 
 void DerivativeSet::postSiblingsLoad() noexcept(false) {
@@ -118,13 +134,100 @@ void DerivativeSet::postSiblingsLoad() noexcept(false) {
         }
         userSet->postSiblingsLoad();
         derivesFrom_->push_back(userSet);
+        userSet->addDependent(this);
     }
 
     postSiblingsLoading = false;
     postSiblingsLoaded = true;
-    updateElements();
+    // the elements are computed by postParentLoad, once every set this derives from is up to date
     return postPostSiblingsLoad();
 }
 
 void DerivativeSet::postPostSiblingsLoad() noexcept(false) {
+}
+
+ElementDelta DerivativeSet::applyDelta(const ElementDelta& inputDelta) noexcept {
+    if (inputDelta.unbounded) {
+        computedFromVersions_.clear();
+        ElementDelta delta;
+        delta.unbounded = true;
+        return delta;
+    }
+    // an element can only change membership if its membership of something this is computed from changed
+    std::vector<ElementId> candidates;
+    std::set_union(inputDelta.added.begin(), inputDelta.added.end(), inputDelta.removed.begin(), inputDelta.removed.end(), std::back_inserter(candidates));
+
+    ElementDelta delta;
+    for (auto element : candidates) {
+        bool derived = derives(element);
+        if (derived == holds(element)) {
+            continue;
+        }
+        if (elements_ != nullptr) {
+            derived ? elements_->insert(element) : elements_->erase(element);
+        } else {
+            derived ? complementElements_->erase(element) : complementElements_->insert(element);
+        }
+        (derived ? delta.added : delta.removed).push_back(element);
+    }
+    computedFromVersions_ = inputVersions(false);
+    return delta;
+}
+
+void DerivativeSet::recompute() noexcept {
+    computedFromVersions_.clear();
+    refresh();
+}
+
+bool DerivativeSet::recomputesConcurrently() const noexcept {
+    return true;
+}
+
+void DerivativeSet::refresh() const noexcept {
+    if (!computedFromVersions_.empty() && computedFromVersions_ == inputVersions(true)) {
+        return;
+    }
+    // computing the elements once they are read only changes when they are computed, not what the set holds
+    auto* self = const_cast<DerivativeSet*>(this);
+    self->updateElements();
+    self->computedFromVersions_ = inputVersions(false);
+    ++self->version_;
+}
+
+bool DerivativeSet::current() const noexcept {
+    if (computedFromVersions_.empty() || computedFromVersions_ != inputVersions(false) || !parent_->current()) {
+        return false;
+    }
+    return std::all_of(derivesFrom_->begin(), derivesFrom_->end(), [](const UserSet* userSet) {
+        return userSet->current();
+    });
+}
+
+std::vector<uint64_t> DerivativeSet::inputVersions(bool upToDate) const noexcept {
+    std::vector<uint64_t> versions;
+    versions.reserve(derivesFrom_->size() + 1);
+    versions.push_back(upToDate ? parent_->version() : parent_->version_);
+    for (const auto* userSet : *derivesFrom_) {
+        versions.push_back(upToDate ? userSet->version() : userSet->version_);
+    }
+    return versions;
+}
+
+bool DerivativeSet::holds(ElementId element) const noexcept {
+    if (elements_ != nullptr) {
+        return elements_->contains(element);
+    }
+    return !complementElements_->contains(element);
+}
+
+void DerivativeSet::detach() noexcept {
+    SubSet::detach();
+    for (auto* userSet : *derivesFrom_) {
+        userSet->removeDependent(this);
+    }
+}
+
+void DerivativeSet::replaceOperand(UserSet* replaced, UserSet* replacement) noexcept {
+    std::replace(derivesFrom_->begin(), derivesFrom_->end(), replaced, replacement);
+    computedFromVersions_.clear();
 }
\ No newline at end of file
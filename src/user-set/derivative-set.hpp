@@ -20,30 +20,49 @@ class DerivativeSet : public SubSet {
         DerivativeSet(
             UserSet* parent,
             const std::string& name,
-            std::initializer_list<UserSet*> userSets,
-            std::unique_ptr<std::set<std::string>> elements = std::unique_ptr<std::set<std::string>>(),
-            std::unique_ptr<std::set<std::string>> complementElements = std::unique_ptr<std::set<std::string>>()
+            std::vector<UserSet*> userSets,
+            std::unique_ptr<ElementSet> elements = std::unique_ptr<ElementSet>(),
+            std::unique_ptr<ElementSet> complementElements = std::unique_ptr<ElementSet>()
         ) noexcept;
         // Note: It is undefined behavior to instantiate this class with the parent, name constructor and then not run postSiblingsLoad() hook
         DerivativeSet(
             UserSet* parent,
             const std::string& name,
-            std::unique_ptr<std::set<std::string>> elements = std::unique_ptr<std::set<std::string>>(),
-            std::unique_ptr<std::set<std::string>> complementElements = std::unique_ptr<std::set<std::string>>()
+            std::unique_ptr<ElementSet> elements = std::unique_ptr<ElementSet>(),
+            std::unique_ptr<ElementSet> complementElements = std::unique_ptr<ElementSet>()
         ) noexcept;
         virtual ~DerivativeSet() noexcept;
 
         const std::vector<UserSet*>& derivesFrom() const noexcept;
 
-        void saveMachineSubset(std::ostream& saveLocation) noexcept override;
-        void loadMachineSubset(std::istream& saveLocation) noexcept override;
-        virtual void saveMachineDerivativeSubset(std::ostream& saveLocation) noexcept;
-        virtual void loadMachineDerivativeSubset(std::istream& loadLocation) noexcept;
+        void saveMachineSubset(MachineWriter& saveLocation) noexcept override;
+        void loadMachineSubset(MachineReader& loadLocation) noexcept override;
+        virtual void saveMachineDerivativeSubset(MachineWriter& saveLocation) noexcept;
+        virtual void loadMachineDerivativeSubset(MachineReader& loadLocation) noexcept;
 
         void postSiblingsLoad() noexcept(false) override;
         virtual void postPostSiblingsLoad() noexcept(false);
+        void detach() noexcept override;
+        // updates only the elements in inputDelta, by recomputing whether each of them is derived,
+        // or if the changes are unbounded, leaves every element to be recomputed the next time the set is read
+        ElementDelta applyDelta(const ElementDelta& inputDelta) noexcept override;
+        void recompute() noexcept override;
+        // computing a derivative set only reads the sets it is computed from
+        bool recomputesConcurrently() const noexcept override;
+        // whether element is in the set derived from the current elements of the sets this derives from, regardless of the elements this set holds
+        virtual bool derives(ElementId element) const noexcept = 0;
+
+        // makes this set derive from replacement wherever it derived from replaced
+        void replaceOperand(UserSet* replaced, UserSet* replacement) noexcept;
     protected:
+        // recomputes the elements if the version of the parent or any set this derives from moved since they were last computed
+        void refresh() const noexcept override;
+        // whether the elements are computed from the current versions of the parent and every set this derives from, and each of those is current too
+        bool current() const noexcept override;
+
         std::vector<UserSet*>& derivesFrom() noexcept;
+        // queries for at least two subsets of parent and then for more until the subset menu is exited, returning none if it is exited before the first two are picked
+        static std::vector<UserSet*> queryForSubsets(UserSet& parent) noexcept;
     private:
         union {
             std::vector<UserSet*>* derivesFrom_;
@@ -51,4 +70,11 @@ class DerivativeSet : public SubSet {
         };
         bool postSiblingsLoading = false;
         bool postSiblingsLoaded = false;
+        // the versions of the parent and then of every set this derives from that the elements were last computed from, or none if they are not
+        std::vector<uint64_t> computedFromVersions_;
+
+        // the versions of the parent and then of every set this derives from, either as they are stored, or once each of them is brought up to date
+        std::vector<uint64_t> inputVersions(bool upToDate) const noexcept;
+        // whether element is in the elements as they are stored
+        bool holds(ElementId element) const noexcept;
 }; 
\ No newline at end of file
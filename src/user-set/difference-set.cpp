@@ -28,56 +28,9 @@ UserSet* DifferenceSet::createSet(UserSet& parent, const std::string& name) noex
 }
 
 void DifferenceSet::updateElements() noexcept {
-    elements_.release();
-    complementElements_.release();
-
-    const auto* set1Elements = derivesFrom().at(0)->elements();
-    const auto* set2Elements = derivesFrom().at(1)->elements();
+    assign(applySetOperation<SetOperation::DIFFERENCE>(derivesFrom().at(0)->view(), derivesFrom().at(1)->view()));
+}
 
-    if (set1Elements == nullptr && set2Elements != nullptr) {
-        // infinite - finite will always be infinite, anything else (including infinite - infinite) will always be finite
-        complementElements_ = std::make_unique<std::set<std::string>>();
-        const auto* set1ComplementElements = derivesFrom().at(0)->complementElements();
-        // https://proofwiki.org/wiki/Set_Difference_as_Intersection_with_Complement
-        // A Difference B = A Intersect ~B
-        // => ~(A Difference B) = ~(A Intersect ~B)
-        // https://proofwiki.org/wiki/De_Morgan%27s_Laws_(Set_Theory)/Set_Complement/Complement_of_Union
-        // ~(A Intersect B) = ~A Union ~B
-        // => ~(A Difference B) = ~A Union B
-        std::set_union(
-            set1ComplementElements->begin(), set1ComplementElements->end(),
-            set2Elements->begin(), set2Elements->end(),
-            std::inserter(*complementElements_, complementElements_->begin())
-        );
-    } else {
-        elements_ = std::make_unique<std::set<std::string>>();
-        if (set1Elements == nullptr && set2Elements == nullptr) {
-            // https://proofwiki.org/wiki/Set_Difference_of_Complements
-            // ~B Difference ~A = A Difference B
-            // => A Difference B = ~B Difference ~A
-            const auto* set1ComplementElements = derivesFrom().at(0)->complementElements();
-            const auto* set2ComplementElements = derivesFrom().at(1)->complementElements();
-            std::set_difference(
-                set2ComplementElements->begin(), set2ComplementElements->end(),
-                set1ComplementElements->begin(), set1ComplementElements->end(),
-                std::inserter(*elements_, elements_->begin())
-            );
-        } else if (set2Elements == nullptr) {
-            // https://proofwiki.org/wiki/Set_Difference_as_Intersection_with_Complement
-            // A Difference B = A Intersect ~B
-            const auto* set2ComplementElements = derivesFrom().at(1)->complementElements();
-            std::set_intersection(
-                set1Elements->begin(), set1Elements->end(),
-                set2ComplementElements->begin(), set2ComplementElements->end(),
-                std::inserter(*elements_, elements_->begin())
-            );
-        } else {
-            // does exactly what it says
-            std::set_difference(
-                set1Elements->begin(), set1Elements->end(),
-                set2Elements->begin(), set2Elements->end(),
-                std::inserter(*elements_, elements_->begin())
-            );
-        }
-    }
+bool DifferenceSet::derives(ElementId element) const noexcept {
+    return derivesFrom().at(0)->contains(element) && !derivesFrom().at(1)->contains(element);
 }
\ No newline at end of file
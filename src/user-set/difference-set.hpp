@@ -18,5 +18,8 @@ class DifferenceSet : public DerivativeSet {
         static constexpr char type_ = '-';
         char type() const noexcept override { return type_; }
         void updateElements() noexcept override;
+        // #endregion
+        // #region DerivativeSet public members override
+        bool derives(ElementId element) const noexcept override;
         // #endregion 
 };
\ No newline at end of file
@@ -10,16 +10,17 @@
 
 #include "helpers.hpp"
 #include "platform.hpp"
+#include "derivative-set.hpp"
 
 #include <filesystem>
 #include <locale>
 
 DirectorySet::DirectorySet(UserSet* parent, const std::string& name) noexcept
-    : SubSet(parent, name, std::make_unique<std::set<std::string>>())
+    : SubSet(parent, name, std::make_unique<ElementSet>())
 {}
 
 DirectorySet::DirectorySet(UserSet* parent, const std::string& name, const std::filesystem::path& directory) noexcept
-    : SubSet(parent, name, std::make_unique<std::set<std::string>>()), directory_(std::filesystem::absolute(directory)), denativeDirectory_(denativePath(directory_))
+    : SubSet(parent, name, std::make_unique<ElementSet>()), directory_(std::filesystem::absolute(directory)), denativeDirectory_(denativePath(directory_))
 {
     updateElements();
 }
@@ -50,8 +51,18 @@ void DirectorySet::changeDirectory() noexcept {
     std::getline(nowide::cin, directory);
     directory_ = std::filesystem::absolute(nativeString(directory));
     denativeDirectory_ = denativePath(directory_);
+    if (auto* record = journal_->record(EditJournal::Operation::CHANGE_DIRECTORY, *this)) {
+        saveMachineSubset(*record);
+    }
 
+    auto previousElements = *elements_;
     updateElements();
+    auto addedElements = ElementSet::difference(*elements_, previousElements);
+    auto removedElements = ElementSet::difference(previousElements, *elements_);
+    updateDownstream({
+        std::vector<ElementId>(addedElements.begin(), addedElements.end()),
+        std::vector<ElementId>(removedElements.begin(), removedElements.end())
+    });
 }
 
 void DirectorySet::listMirroredDirectory() noexcept {
@@ -70,49 +81,53 @@ void DirectorySet::handleDirectoryError() noexcept {
     std::string input;
     nowide::cin >> input;
     if (std::toupper(input[0]) == 'D') {
+        const auto* dependent = outsideDependent();
+        if (dependent != nullptr) {
+            nowide::cout << "This set cannot be deleted while '" << dependent->name() << "' derives from it or its subsets, continuing with the previously gathered directory contents.\n";
+            return;
+        }
         parent()->onQueryRemove = this;
         queryable = false;
         setSpecificQueryable = false;
     }
     if (std::toupper(input[0]) == 'E') {
-        exit(0);
+        exitWithoutSaving();
     }
 }
 
-void DirectorySet::saveMachineSubset(std::ostream& saveLocation) noexcept {
-    saveLocation << directory().size() << ' ' << directory();
+void DirectorySet::saveMachineSubset(MachineWriter& saveLocation) noexcept {
+    saveLocation.writeString(directory());
 }
 
-void DirectorySet::loadMachineSubset(std::istream& loadLocation) noexcept {
-    size_t directorySize;
-    loadLocation >> directorySize;
-    
-    std::string directoryString = std::string(directorySize + 1, '\0');
-    skipRead(loadLocation, 1);
-    loadLocation.read(directoryString.data(), directorySize);
+void DirectorySet::loadMachineSubset(MachineReader& loadLocation) noexcept {
+    std::string directoryString(loadLocation.readString());
 
     directory_ = std::filesystem::absolute(nativeString(directoryString));
     denativeDirectory_ = denativePath(directory_);
 }
 
 void DirectorySet::updateElements() noexcept {
-    std::set<std::string> newElements;
+    std::vector<ElementId> newElementIds;
     try {
         if (!std::filesystem::is_directory(directory_)) {
             throw std::logic_error("Unresolveable, Directory set created on directory that does not exist.");
         }
         for (const auto& entry : std::filesystem::directory_iterator(directory_)) {
-            newElements.insert(denativePath(entry.path().lexically_relative(directory_)));
+            newElementIds.push_back(dictionary().intern(denativePath(entry.path().lexically_relative(directory_))));
         }
     } catch (...) {
         handleDirectoryError();
         return;
     }
-    for (const auto& element : *elements_) {
-        if (newElements.find(element) == newElements.end()) {
-            removedElement(element, false);
-        }
-    }
+    ElementSet newElements(std::move(newElementIds));
+    auto lostElements = ElementSet::difference(*elements_, newElements);
+    removedElements(lostElements, false);
 
+    index_->erase(this, lostElements);
+    index_->insert(this, ElementSet::difference(newElements, *elements_));
     *elements_ = std::move(newElements);
 }
+
+std::vector<const ElementSet*> DirectorySet::indexedElements() const noexcept {
+    return {elements_.get()};
+}
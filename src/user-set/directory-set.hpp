@@ -24,9 +24,10 @@ class DirectorySet : public SubSet {
         static constexpr char type_ = 'D';
         char type() const noexcept override { return type_; }
 
-        void saveMachineSubset(std::ostream& saveLocation) noexcept override;
-        void loadMachineSubset(std::istream& loadLocation) noexcept override;
+        void saveMachineSubset(MachineWriter& saveLocation) noexcept override;
+        void loadMachineSubset(MachineReader& loadLocation) noexcept override;
         void updateElements() noexcept override;
+        std::vector<const ElementSet*> indexedElements() const noexcept override;
         // #endregion 
 
         void changeDirectory() noexcept;
@@ -0,0 +1,343 @@
+/*
+    edit-journal.cpp
+
+    EditJournal records every change made to a set hierarchy since it was last saved, so that saving to the default location only appends those changes
+    to a journal next to the saved sets, rather than saving every set again, and loading from it replays them on top of what was saved in full
+    The journal starts with a header identifying the saved sets it applies to, followed by a batch of records for every save since they were saved in full,
+    each written in the text encoding of the machine format and followed by its checksum, so that a batch that was only partly written is never replayed
+
+    Once the journal grows large next to the full save, it is compacted on a thread of its own, which saves the sets in full in place of the full save,
+    then marks the journal as applying to that save from where it was compacted, and finally rewrites it without everything before that
+*/
+#include "edit-journal.hpp"
+
+#include "user-set.hpp"
+#include "platform.hpp"
+
+#include <system_error>
+#include <algorithm>
+
+namespace {
+    constexpr std::string_view HEADER = "set-journal";
+    constexpr size_t VERSION = 1;
+    // the journal is compacted once it is larger than this much of the full save, as long as it is larger than the least it is ever compacted at,
+    // so that replaying it never takes long next to loading what is saved in full
+    constexpr size_t COMPACTION_DIVISOR = 4;
+    constexpr size_t MIN_COMPACTION_SIZE = 1 << 16;
+
+    // 32 bit FNV-1a, which only has to tell a batch that was written whole apart from one that was not
+    size_t checksum(std::string_view batch) noexcept {
+        uint32_t hash = 2166136261u;
+        for (auto character : batch) {
+            hash ^= static_cast<unsigned char>(character);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    // identifies what is saved at savedLocation by its size and when it was last written, which the journal next to it is checked against before it is replayed
+    bool savedIdentity(const std::filesystem::path& savedLocation, size_t& size, size_t& writeTime) noexcept {
+        std::error_code error;
+        size = std::filesystem::file_size(savedLocation, error);
+        if (error) {
+            return false;
+        }
+        writeTime = static_cast<size_t>(std::filesystem::last_write_time(savedLocation, error).time_since_epoch().count());
+        return !error;
+    }
+
+    // the start of a journal that applies to a full save of savedSize, last written at savedTime
+    std::string header(const ElementDictionary& dictionary, size_t savedSize, size_t savedTime) noexcept {
+        std::ostringstream header;
+        TextMachineWriter writer(header, dictionary);
+        writer.writeString(HEADER);
+        writer.writeSize(VERSION);
+        writer.writeSize(savedSize);
+        writer.writeSize(savedTime);
+        header << '\n';
+        return header.str();
+    }
+
+    // writes contents to a temporary file next to location, through to the disk, which then replaces location, returning whether it did
+    bool writeReplacing(const std::filesystem::path& location, std::string_view contents) noexcept {
+        auto temporaryLocation = location;
+        temporaryLocation += ".tmp";
+        {
+            nowide::ofstream file(denativePath(temporaryLocation), std::ios::out | std::ios::binary);
+            file.write(contents.data(), contents.size());
+            if (!file.flush()) {
+                return false;
+            }
+        }
+        syncFile(temporaryLocation);
+        std::error_code error;
+        std::filesystem::rename(temporaryLocation, location, error);
+        return !error;
+    }
+}
+
+EditJournal::EditJournal(ElementDictionary& dictionary) noexcept
+    : dictionary_(dictionary)
+{
+    clearRecords();
+}
+
+EditJournal::~EditJournal() noexcept {
+    waitForCompaction();
+}
+
+MachineWriter* EditJournal::record(Operation operation, const UserSet& set) noexcept {
+    if (paused_ > 0 || !valid_) {
+        return nullptr;
+    }
+    // the set is found by the names of the sets down to it from the top set, which has no name of its own in the path
+    std::vector<std::string_view> path;
+    for (const auto* ancestor = &set; ancestor->parent() != nullptr; ancestor = ancestor->parent()) {
+        path.push_back(ancestor->name());
+    }
+    writer_->writeSize(static_cast<size_t>(operation));
+    writer_->writeSize(path.size());
+    for (auto nameIt = path.rbegin(); nameIt != path.rend(); ++nameIt) {
+        writer_->writeString(*nameIt);
+    }
+    return writer_.get();
+}
+
+void EditJournal::pause() noexcept {
+    ++paused_;
+}
+
+void EditJournal::resume() noexcept {
+    --paused_;
+}
+
+std::vector<std::string> EditJournal::load(const std::filesystem::path& savedLocation) noexcept {
+    waitForCompaction();
+    savedLocation_ = savedLocation;
+    valid_ = false;
+    clearRecords();
+
+    std::vector<std::string> batches;
+    std::error_code error;
+    if (!std::filesystem::exists(location(), error)) {
+        return batches;
+    }
+    // the batches before this are in what is saved in full
+    size_t firstReplayed = 0;
+    size_t savedSize = 0;
+    size_t savedTime = 0;
+    bool identified = savedIdentity(savedLocation, savedSize, savedTime);
+    bool applies = false;
+    bool torn = false;
+    {
+        nowide::ifstream journalFile(denativePath(location()), std::ios::in | std::ios::binary);
+        TextMachineReader reader(journalFile, dictionary_);
+        bool isJournal = reader.readString() == HEADER;
+        auto version = reader.readSize();
+        auto journaledSize = reader.readSize();
+        auto journaledTime = reader.readSize();
+        isJournal = isJournal && version == VERSION && reader.error().empty();
+        applies = isJournal && identified && journaledSize == savedSize && journaledTime == savedTime;
+
+        while (isJournal && !reader.atEnd()) {
+            std::string batch(reader.readString());
+            if (reader.error().empty() && batch.empty()) {
+                // a compaction saved the sets in full as they were once the first compactedBatches batches were saved, marking the full save with its size and time,
+                // which is only what is saved if the compaction replaced it, even if the journal was not yet rewritten after,
+                // while the batches saved as it was running come between those and the mark
+                auto compactedSize = reader.readSize();
+                auto compactedTime = reader.readSize();
+                auto compactedBatches = reader.readSize();
+                if (identified && reader.error().empty() && compactedSize == savedSize && compactedTime == savedTime && compactedBatches <= batches.size()) {
+                    firstReplayed = compactedBatches;
+                    applies = true;
+                }
+                continue;
+            }
+            auto batchChecksum = reader.readSize();
+            if (!reader.error().empty() || batchChecksum != checksum(batch)) {
+                torn = true;
+                break;
+            }
+            batches.push_back(std::move(batch));
+        }
+    }
+    journalBatches_ = batches.size();
+    batches.erase(batches.begin(), batches.begin() + firstReplayed);
+    if (applies && torn) {
+        // saving in full next replaces the journal, along with what was only partly written to it
+        nowide::cout << "The journal " << location() << " ends in changes that were only partly saved, which were not replayed.\n";
+        return batches;
+    }
+    if (!applies) {
+        batches.clear();
+        auto backupLocation = location();
+        backupLocation += ".bak";
+        std::filesystem::rename(location(), backupLocation, error);
+        nowide::cout << "The journal " << location() << " is not of the sets saved at " << savedLocation << ", so it was not replayed, and was moved to " << backupLocation << ".\n";
+        return batches;
+    }
+    savedSize_ = savedSize;
+    journalSize_ = std::filesystem::file_size(location(), error);
+    valid_ = true;
+    return batches;
+}
+
+bool EditJournal::save() noexcept {
+    std::error_code error;
+    if (!valid_ || !std::filesystem::is_regular_file(location(), error)) {
+        waitForCompaction();
+        return false;
+    }
+    if (records_.tellp() == 0) {
+        return true;
+    }
+    writer_->writeSize(static_cast<size_t>(Operation::END));
+    auto batch = records_.str();
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    {
+        nowide::ofstream journalFile(denativePath(location()), std::ios::out | std::ios::binary | std::ios::app);
+        TextMachineWriter frame(journalFile, dictionary_);
+        frame.writeString(batch);
+        frame.writeSize(checksum(batch));
+        journalFile << '\n';
+        if (!journalFile.flush()) {
+            // whatever part of the batch was written is never replayed, as its checksum cannot match
+            valid_ = false;
+            return false;
+        }
+        journalSize_ = journalFile.tellp();
+        ++journalBatches_;
+    }
+    // every batch is written through to the disk once, rather than every record on its own
+    syncFile(location());
+    clearRecords();
+    return true;
+}
+
+void EditJournal::restart(const std::filesystem::path& savedLocation) noexcept {
+    waitForCompaction();
+    savedLocation_ = savedLocation;
+    valid_ = false;
+    clearRecords();
+
+    size_t savedSize = 0;
+    size_t savedTime = 0;
+    if (!savedIdentity(savedLocation, savedSize, savedTime)) {
+        return;
+    }
+    auto journal = header(dictionary_, savedSize, savedTime);
+    if (!writeReplacing(location(), journal)) {
+        return;
+    }
+    savedSize_ = savedSize;
+    journalSize_ = journal.size();
+    journalBatches_ = 0;
+    valid_ = true;
+}
+
+void EditJournal::invalidate() noexcept {
+    waitForCompaction();
+    valid_ = false;
+    clearRecords();
+}
+
+bool EditJournal::compactionDue() noexcept {
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    return valid_ && !compacting_ && journalSize_ > std::max(savedSize_ / COMPACTION_DIVISOR, MIN_COMPACTION_SIZE);
+}
+
+void EditJournal::compact(MachineRecording saved, ElementDictionary dictionary) noexcept {
+    waitForCompaction();
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    compacting_ = true;
+    compaction_ = std::thread(&EditJournal::writeCompacted, this, std::move(saved), std::move(dictionary), journalSize_, journalBatches_);
+}
+
+void EditJournal::writeCompacted(MachineRecording saved, ElementDictionary dictionary, size_t journalEnd, size_t journalBatches) noexcept {
+    // nothing else writes next to the full save while a compaction is running, as full saves and loads wait for it first
+    auto compactedLocation = savedLocation_;
+    compactedLocation += ".compacted";
+    size_t savedSize = 0;
+    size_t savedTime = 0;
+    bool written = false;
+    {
+        nowide::ofstream compactedFile(denativePath(compactedLocation), std::ios::out | std::ios::binary);
+        // the same as UserSet::saveMachineSubsets, from the recording
+        MachineElementCollector savedElements(dictionary);
+        saved.replay(savedElements);
+        {
+            BinaryMachineWriter writer(compactedFile, dictionary, savedElements.elements());
+            saved.replay(writer);
+        }
+        written = static_cast<bool>(compactedFile.flush());
+    }
+    saved = MachineRecording();
+    if (written) {
+        syncFile(compactedLocation);
+        written = savedIdentity(compactedLocation, savedSize, savedTime);
+    }
+
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    compacting_ = false;
+    if (!written) {
+        return;
+    }
+    // the mark goes on the disk before the full save is replaced, so that the journal applies to the sets saved at either point
+    auto markStart = journalSize_;
+    {
+        nowide::ofstream journalFile(denativePath(location()), std::ios::out | std::ios::binary | std::ios::app);
+        TextMachineWriter mark(journalFile, dictionary_);
+        mark.writeString("");
+        mark.writeSize(savedSize);
+        mark.writeSize(savedTime);
+        mark.writeSize(journalBatches);
+        journalFile << '\n';
+        if (!journalFile.flush()) {
+            return;
+        }
+        journalSize_ = journalFile.tellp();
+    }
+    syncFile(location());
+    std::error_code error;
+    std::filesystem::rename(compactedLocation, savedLocation_, error);
+    if (error) {
+        return;
+    }
+    savedSize_ = savedSize;
+
+    // the batches saved while the full save was being written are all that is left of the journal
+    std::string journal = header(dictionary_, savedSize, savedTime);
+    {
+        nowide::ifstream journalFile(denativePath(location()), std::ios::in | std::ios::binary);
+        journalFile.seekg(journalEnd);
+        std::string frames(markStart - journalEnd, '\0');
+        journalFile.read(frames.data(), frames.size());
+        if (!journalFile) {
+            return;
+        }
+        journal.append(frames);
+    }
+    if (writeReplacing(location(), journal)) {
+        journalSize_ = journal.size();
+        journalBatches_ -= journalBatches;
+    }
+}
+
+void EditJournal::waitForCompaction() noexcept {
+    if (compaction_.joinable()) {
+        compaction_.join();
+    }
+}
+
+void EditJournal::clearRecords() noexcept {
+    records_.str("");
+    records_.clear();
+    writer_ = std::make_unique<TextMachineWriter>(records_, dictionary_);
+}
+
+std::filesystem::path EditJournal::location() const noexcept {
+    auto location = savedLocation_;
+    location += ".journal";
+    return location;
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+/*
+    edit-journal.hpp
+
+    EditJournal records every change made to a set hierarchy since it was last saved, so that saving to the default location only appends those changes
+    to a journal next to the saved sets, rather than saving every set again, and loading from it replays them on top of what was saved in full
+    The journal starts with a header identifying the saved sets it applies to, followed by a batch of records for every save since they were saved in full,
+    each written in the text encoding of the machine format and followed by its checksum, so that a batch that was only partly written is never replayed
+
+    Once the journal grows large next to the full save, it is compacted on a thread of its own, which saves the sets in full in place of the full save,
+    then marks the journal as applying to that save from where it was compacted, and finally rewrites it without everything before that
+*/
+#pragma once
+
+#include "machine-format.hpp"
+#include "element-dictionary.hpp"
+
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+
+class UserSet;
+
+class EditJournal {
+    public:
+        // what a record did to the set it is of, which the rest of the record follows
+        enum class Operation : size_t {
+            // the end of a batch
+            END = 0,
+            // an element string inserted into or erased from the elements the set stores itself
+            INSERT,
+            ERASE,
+            // the record of the subset created in the set, as it is saved
+            CREATE,
+            DELETE,
+            // whether the set is included in human readable output, followed by whether its nested subsets were set to the same
+            HUMAN_INCLUSION,
+            // the word set was replaced by a faux word set with its words
+            BECOME_FAUX,
+            // the section the directory set saves, holding its new directory
+            CHANGE_DIRECTORY
+        };
+
+        EditJournal(ElementDictionary& dictionary) noexcept;
+        // waits for a compaction that is still running to finish
+        ~EditJournal() noexcept;
+
+        // starts a record of operation on set, returning what to write the rest of the record with,
+        // or nullptr if changes are not being recorded, while they are being replayed or undone, or when the next save is a full one anyway
+        MachineWriter* record(Operation operation, const UserSet& set) noexcept;
+        // stops recording changes until resumed as many times as this was called
+        void pause() noexcept;
+        void resume() noexcept;
+
+        // reads the journal next to savedLocation, which is about to be loaded, returning each batch of records in it to be replayed in order,
+        // and discards every record since the last save, as the sets they were made to are being replaced
+        std::vector<std::string> load(const std::filesystem::path& savedLocation) noexcept;
+        // appends every record since the last save to the journal as a batch, and writes it through to the disk,
+        // returning false instead if the journal does not apply to what is saved, so everything has to be saved in full, which a compaction is never running along with
+        bool save() noexcept;
+        // whether the journal has grown large enough next to the full save that it should be compacted, which it never is while a compaction is running
+        bool compactionDue() noexcept;
+        // starts compacting the journal into saved, a recording of the sets as they were just saved, with a snapshot of the dictionary of their elements,
+        // which the compaction thread encodes and writes in full in place of what is saved, while changes keep being recorded and saved to the journal meanwhile
+        void compact(MachineRecording saved, ElementDictionary dictionary) noexcept;
+        // starts an empty journal for the sets that were just saved in full to savedLocation
+        void restart(const std::filesystem::path& savedLocation) noexcept;
+        // makes the next save a full one, as the sets no longer match what the journal applies to
+        void invalidate() noexcept;
+    private:
+        void clearRecords() noexcept;
+        std::filesystem::path location() const noexcept;
+        // runs on the compaction thread, where journalEnd is how much of the journal saved holds the changes of, which are its first journalBatches batches
+        void writeCompacted(MachineRecording saved, ElementDictionary dictionary, size_t journalEnd, size_t journalBatches) noexcept;
+        void waitForCompaction() noexcept;
+
+        ElementDictionary& dictionary_;
+        // where the sets the journal applies to are saved, which is empty until they are loaded from or saved to somewhere
+        std::filesystem::path savedLocation_;
+        // whether appending to the journal saves the sets, which is only once the sets are loaded from or saved to savedLocation
+        bool valid_ = false;
+        size_t paused_ = 0;
+        // the sizes of the full save and of the journal, which the compaction thread changes as it finishes
+        size_t savedSize_ = 0;
+        size_t journalSize_ = 0;
+        // how many batches the journal holds, which a compaction marks how many of it saved the changes of
+        size_t journalBatches_ = 0;
+        // guards the journal file, which the compaction thread rewrites, along with the sizes
+        std::mutex fileMutex_;
+        std::thread compaction_;
+        bool compacting_ = false;
+        // the records since the last save
+        std::ostringstream records_;
+        std::unique_ptr<TextMachineWriter> writer_;
+};
\ No newline at end of file
@@ -0,0 +1,106 @@
+/*
+    element-index.cpp
+
+    ElementIndex maps every element of a set hierarchy to the sets that store it, so that finding the sets an element is in only looks at those sets
+    A single index is owned by the GlobalSet, and only tracks the sets that store their elements themselves rather than computing them from other sets,
+    which every set keeps up to date whenever its stored elements change
+*/
+#include "element-index.hpp"
+
+#include "user-set.hpp"
+
+#include <algorithm>
+
+namespace {
+    const std::vector<const UserSet*> NO_SETS;
+}
+
+bool ElementIndex::enabled() const noexcept {
+    return enabled_;
+}
+
+void ElementIndex::enable(const UserSet& root) noexcept {
+    postings_.clear();
+    enabled_ = true;
+    insertAll(root);
+}
+
+void ElementIndex::disable() noexcept {
+    enabled_ = false;
+    // releases the memory of the postings rather than only emptying them
+    std::vector<std::vector<const UserSet*>>().swap(postings_);
+}
+
+void ElementIndex::insertAll(const UserSet& set) noexcept {
+    for (const auto* elements : set.indexedElements()) {
+        insert(&set, *elements);
+    }
+    for (const auto& subset : set.subsets()) {
+        insertAll(*subset.second);
+    }
+}
+
+void ElementIndex::insert(const UserSet* set, ElementId element) noexcept {
+    if (!enabled_) {
+        return;
+    }
+    if (element >= postings_.size()) {
+        postings_.resize(element + 1);
+    }
+    auto& sets = postings_[element];
+    if (std::find(sets.begin(), sets.end(), set) == sets.end()) {
+        sets.push_back(set);
+    }
+}
+
+void ElementIndex::insert(const UserSet* set, const ElementSet& elements) noexcept {
+    for (auto element : elements) {
+        insert(set, element);
+    }
+}
+
+void ElementIndex::erase(const UserSet* set, ElementId element) noexcept {
+    if (element >= postings_.size()) {
+        return;
+    }
+    auto& sets = postings_[element];
+    auto setIt = std::find(sets.begin(), sets.end(), set);
+    if (setIt != sets.end()) {
+        // the order of the sets does not matter, so the last one fills the gap
+        *setIt = sets.back();
+        sets.pop_back();
+    }
+}
+
+void ElementIndex::erase(const UserSet* set, const ElementSet& elements) noexcept {
+    for (auto element : elements) {
+        erase(set, element);
+    }
+}
+
+const std::vector<const UserSet*>& ElementIndex::sets(ElementId element) const noexcept {
+    if (element >= postings_.size()) {
+        return NO_SETS;
+    }
+    return postings_[element];
+}
+
+std::set<const UserSet*> ElementIndex::subsetsStoring(const UserSet& parent, const ElementSet& elements) const noexcept {
+    std::set<const UserSet*> subsets;
+    // every set is walked up from once, however many of elements it stores
+    std::set<const UserSet*> walked;
+    for (auto element : elements) {
+        for (const auto* set : sets(element)) {
+            if (!walked.insert(set).second) {
+                continue;
+            }
+            for (; set != nullptr && set != &parent; set = set->parent()) {
+                if (set->parent() == &parent) {
+                    subsets.insert(set);
+                    break;
+                }
+            }
+        }
+    }
+    return subsets;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+/*
+    element-index.hpp
+
+    ElementIndex maps every element of a set hierarchy to the sets that store it, so that finding the sets an element is in only looks at those sets
+    A single index is owned by the GlobalSet, and only tracks the sets that store their elements themselves rather than computing them from other sets,
+    which every set keeps up to date whenever its stored elements change
+*/
+#pragma once
+
+#include "element-set.hpp"
+
+#include <set>
+#include <vector>
+
+class UserSet;
+
+class ElementIndex {
+    public:
+        bool enabled() const noexcept;
+        // starts tracking every set of the hierarchy root is the top of
+        void enable(const UserSet& root) noexcept;
+        // stops tracking any set, so changing stored elements no longer costs anything extra
+        void disable() noexcept;
+
+        void insert(const UserSet* set, ElementId element) noexcept;
+        void insert(const UserSet* set, const ElementSet& elements) noexcept;
+        void erase(const UserSet* set, ElementId element) noexcept;
+        void erase(const UserSet* set, const ElementSet& elements) noexcept;
+
+        // the sets that store element, in no particular order
+        const std::vector<const UserSet*>& sets(ElementId element) const noexcept;
+        // the subsets of parent that store any of elements themselves or have a nested subset that does,
+        // found by walking up from each set that stores one of them rather than down from every subset
+        std::set<const UserSet*> subsetsStoring(const UserSet& parent, const ElementSet& elements) const noexcept;
+    private:
+        void insertAll(const UserSet& set) noexcept;
+
+        bool enabled_ = true;
+        // the sets that store each element, indexed by its id
+        std::vector<std::vector<const UserSet*>> postings_;
+};
\ No newline at end of file
@@ -0,0 +1,420 @@
+/*
+    expression-set.cpp
+    Expression set is a derivative set that holds the result of a boolean expression over already existing subsets of its parent, such as (A | B) & ~C ^ D
+
+    The expression is compiled once into a postfix program, which is then evaluated for every element of its operands in a single merged pass over them,
+    so none of the intermediate sets of the expression are ever built
+*/
+#include "expression-set.hpp"
+
+#include "helpers.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <stdexcept>
+
+namespace {
+    typedef ExpressionSet::Instruction Instruction;
+
+    constexpr std::string_view OPERATOR_CHARACTERS = "()|&-^~\"";
+
+    // a recursive descent parser of the expression grammar, from loosest to tightest binding:
+    // union := symmetric ('|' symmetric)*
+    // symmetric := product ('^' product)*
+    // product := complement (('&' | '-') complement)*
+    // complement := '~' complement | '(' union ')' | name
+    class Parser {
+        public:
+            Parser(const std::string& expression, std::vector<Instruction>& program, std::vector<std::string>& operandNames) noexcept
+                : expression_(expression), program_(program), operandNames_(operandNames)
+            {}
+
+            bool parse(std::string& error) noexcept {
+                if (!parseUnion()) {
+                    error = error_;
+                    return false;
+                }
+                skipSpaces();
+                if (position_ != expression_.size()) {
+                    fail("Unexpected '" + std::string(1, expression_[position_]) + "'");
+                    error = error_;
+                    return false;
+                }
+                return true;
+            }
+        private:
+            bool parseUnion() noexcept {
+                if (!parseSymmetric()) {
+                    return false;
+                }
+                while (accept('|')) {
+                    if (!parseSymmetric()) {
+                        return false;
+                    }
+                    emit(Instruction::UNITE);
+                }
+                return true;
+            }
+
+            bool parseSymmetric() noexcept {
+                if (!parseProduct()) {
+                    return false;
+                }
+                while (accept('^')) {
+                    if (!parseProduct()) {
+                        return false;
+                    }
+                    emit(Instruction::SYMMETRIC_DIFFERENCE);
+                }
+                return true;
+            }
+
+            bool parseProduct() noexcept {
+                if (!parseComplement()) {
+                    return false;
+                }
+                while (true) {
+                    Instruction::Operation operation;
+                    if (accept('&')) {
+                        operation = Instruction::INTERSECT;
+                    } else if (accept('-')) {
+                        operation = Instruction::DIFFERENCE;
+                    } else {
+                        return true;
+                    }
+                    if (!parseComplement()) {
+                        return false;
+                    }
+                    emit(operation);
+                }
+            }
+
+            bool parseComplement() noexcept {
+                if (accept('~')) {
+                    // https://proofwiki.org/wiki/Definition:Relative_Complement
+                    // RelativeComplement(P, A) = P Difference A
+                    emit(Instruction::PUSH_PARENT);
+                    if (!parseComplement()) {
+                        return false;
+                    }
+                    emit(Instruction::DIFFERENCE);
+                    return true;
+                }
+                if (accept('(')) {
+                    if (!parseUnion()) {
+                        return false;
+                    }
+                    if (!accept(')')) {
+                        return fail("Expected ')'");
+                    }
+                    return true;
+                }
+                return parseName();
+            }
+
+            bool parseName() noexcept {
+                skipSpaces();
+                std::string name;
+                if (accept('"')) {
+                    size_t end = expression_.find('"', position_);
+                    if (end == std::string::npos) {
+                        return fail("Unterminated quoted name");
+                    }
+                    name = expression_.substr(position_, end - position_);
+                    position_ = end + 1;
+                } else {
+                    size_t start = position_;
+                    while (position_ < expression_.size() && !std::isspace(static_cast<unsigned char>(expression_[position_])) && OPERATOR_CHARACTERS.find(expression_[position_]) == std::string_view::npos) {
+                        ++position_;
+                    }
+                    name = expression_.substr(start, position_ - start);
+                }
+                if (name.empty()) {
+                    return fail("Expected the name of a set");
+                }
+
+                auto nameIt = std::find(operandNames_.begin(), operandNames_.end(), name);
+                if (nameIt == operandNames_.end()) {
+                    nameIt = operandNames_.insert(operandNames_.end(), std::move(name));
+                }
+                program_.push_back(Instruction{Instruction::PUSH_OPERAND, uint32_t(nameIt - operandNames_.begin())});
+                return true;
+            }
+
+            void emit(Instruction::Operation operation) noexcept {
+                program_.push_back(Instruction{operation, 0});
+            }
+
+            bool accept(char character) noexcept {
+                skipSpaces();
+                if (position_ < expression_.size() && expression_[position_] == character) {
+                    ++position_;
+                    return true;
+                }
+                return false;
+            }
+
+            void skipSpaces() noexcept {
+                while (position_ < expression_.size() && std::isspace(static_cast<unsigned char>(expression_[position_]))) {
+                    ++position_;
+                }
+            }
+
+            bool fail(const std::string& message) noexcept {
+                if (error_.empty()) {
+                    error_ = message + " at position " + std::to_string(position_ + 1);
+                }
+                return false;
+            }
+
+            const std::string& expression_;
+            std::vector<Instruction>& program_;
+            std::vector<std::string>& operandNames_;
+            size_t position_ = 0;
+            std::string error_;
+    };
+
+    // evaluates program for one element, given whether each operand and the parent contain it
+    bool evaluate(const std::vector<Instruction>& program, const std::vector<char>& operandMembership, bool parentMembership) {
+        // the stack is kept as bits, with the top of the stack in the lowest bit
+        uint64_t stack = 0;
+        for (const auto& instruction : program) {
+            uint64_t top = stack & 1;
+            switch (instruction.operation) {
+                case Instruction::PUSH_OPERAND:
+                    stack = (stack << 1) | uint64_t(operandMembership[instruction.operand]);
+                    break;
+                case Instruction::PUSH_PARENT:
+                    stack = (stack << 1) | uint64_t(parentMembership);
+                    break;
+                case Instruction::INTERSECT:
+                    stack >>= 1;
+                    stack = (stack & ~uint64_t(1)) | (stack & top);
+                    break;
+                case Instruction::UNITE:
+                    stack >>= 1;
+                    stack |= top;
+                    break;
+                case Instruction::DIFFERENCE:
+                    stack >>= 1;
+                    stack &= ~top;
+                    break;
+                case Instruction::SYMMETRIC_DIFFERENCE:
+                    stack >>= 1;
+                    stack ^= top;
+                    break;
+            }
+        }
+        return stack & 1;
+    }
+
+    // the elements a set keeps, and whether they are its elements or its complement elements
+    struct Source {
+        const ElementSet* elements;
+        bool infinite;
+        ElementSet::const_iterator position;
+    };
+
+    Source sourceOf(const UserSet& userSet) {
+        auto view = userSet.view();
+        return Source{view.stored, view.complemented, view.stored->begin()};
+    }
+}
+
+ExpressionSet::ExpressionSet(UserSet* parent, const std::string& name, std::vector<UserSet*> userSets, std::string expression, std::vector<Instruction> program) noexcept
+    : DerivativeSet(parent, name, std::move(userSets)), expression_(std::move(expression)), program_(std::move(program)), operandCount_(derivesFrom().size())
+{}
+
+ExpressionSet::ExpressionSet(UserSet* parent, const std::string& name) noexcept
+    : DerivativeSet(parent, name)
+{}
+
+UserSet* ExpressionSet::createSet(UserSet& parent, const std::string& name) noexcept {
+    ignoreAll(nowide::cin);
+    while (true) {
+        nowide::cout << "Enter an expression over the subsets of the parent, using | (union), & (intersection), - (difference), ^ (symmetric difference), ~ (complement within the parent) and parentheses,\n"
+                     << "with names that contain spaces or operators wrapped in double quotes, or \"" << UserSet::EXIT_KEYWORD << "\" to exit: ";
+        std::string expression;
+        std::getline(nowide::cin, expression);
+        if (insensitiveSame(expression, UserSet::EXIT_KEYWORD)) {
+            return nullptr;
+        }
+
+        std::vector<Instruction> program;
+        std::vector<std::string> operandNames;
+        std::string error;
+        if (!compile(expression, program, operandNames, error)) {
+            nowide::cout << error << ".\n";
+            continue;
+        }
+
+        std::vector<UserSet*> userSets;
+        userSets.reserve(operandNames.size());
+        for (const auto& operandName : operandNames) {
+            auto subsetIt = parent.subsets().find(operandName);
+            if (subsetIt == parent.subsets().end()) {
+                nowide::cout << "There is no subset named '" << operandName << "'.\n";
+                break;
+            }
+            userSets.push_back(subsetIt->second.get());
+        }
+        if (userSets.size() != operandNames.size()) {
+            continue;
+        }
+
+        return new ExpressionSet(&parent, name, std::move(userSets), std::move(expression), std::move(program));
+    }
+}
+
+bool ExpressionSet::compile(const std::string& expression, std::vector<Instruction>& program, std::vector<std::string>& operandNames, std::string& error) noexcept {
+    program.clear();
+    operandNames.clear();
+    if (!Parser(expression, program, operandNames).parse(error)) {
+        return false;
+    }
+
+    size_t depth = 0;
+    for (const auto& instruction : program) {
+        if (instruction.operation == Instruction::PUSH_OPERAND || instruction.operation == Instruction::PUSH_PARENT) {
+            if (++depth > MAX_STACK_DEPTH) {
+                error = "The expression nests more than " + std::to_string(MAX_STACK_DEPTH) + " operands deep";
+                return false;
+            }
+        } else {
+            --depth;
+        }
+    }
+    return true;
+}
+
+const auto EXPRESSION_SET_MENU = ReinterpretMenu<ExpressionSet, UserSet, void>({
+    {"P", {"Print the expression", &ExpressionSet::printExpression}},
+    {"X", {"Exit set-specific options", &ExpressionSet::exitSetSpecificOptions}},
+    {std::string(UserSet::EXIT_KEYWORD), {"Exit the program", &ExpressionSet::exitProgram}}
+});
+
+const Menu<UserSet, void>& ExpressionSet::setSpecificMenu() const noexcept {
+    return EXPRESSION_SET_MENU;
+}
+
+void ExpressionSet::printExpression() noexcept {
+    nowide::cout << expression_ << '\n';
+}
+
+void ExpressionSet::saveMachineDerivativeSubset(MachineWriter& saveLocation) noexcept {
+    saveLocation.writeString(expression_);
+}
+
+void ExpressionSet::loadMachineDerivativeSubset(MachineReader& loadLocation) noexcept {
+    expression_ = loadLocation.readString();
+
+    // the operands are saved in the order the expression first names them, so compiling it again numbers them the same
+    std::vector<std::string> operandNames;
+    std::string error;
+    if (compile(expression_, program_, operandNames, error)) {
+        operandCount_ = operandNames.size();
+    } else {
+        program_.clear();
+    }
+}
+
+void ExpressionSet::postPostSiblingsLoad() noexcept(false) {
+    if (program_.empty() || operandCount_ != derivesFrom().size()) {
+        throw std::logic_error(std::string("Expression '") + expression_ + "' of expression set '" + std::string(name()) + "' does not match the sets it derives from");
+    }
+}
+
+void ExpressionSet::updateElements() noexcept {
+    // an invalid program can only be loaded, and is reported by postPostSiblingsLoad right after this
+    if (program_.empty() || operandCount_ != derivesFrom().size()) {
+        assign({false, ElementSet()});
+        return;
+    }
+
+    // every operand (and the parent, if the expression complements anything) is a source
+    // an element that is kept by no source is in exactly the infinite sources, so every such element has the same membership (the background),
+    // and only the elements kept by some source can differ from it
+    std::vector<Source> sources;
+    sources.reserve(derivesFrom().size() + 1);
+    for (const auto* userSet : derivesFrom()) {
+        sources.push_back(sourceOf(*userSet));
+    }
+    bool usesParent = std::any_of(program_.begin(), program_.end(), [](const Instruction& instruction) {
+        return instruction.operation == Instruction::PUSH_PARENT;
+    });
+    if (usesParent) {
+        sources.push_back(sourceOf(*parent()));
+    }
+    const size_t operandCount = derivesFrom().size();
+
+    std::vector<char> operandMembership(operandCount);
+    for (size_t i = 0; i < operandCount; ++i) {
+        operandMembership[i] = sources[i].infinite;
+    }
+    bool parentMembership = usesParent && sources.back().infinite;
+    const bool background = evaluate(program_, operandMembership, parentMembership);
+
+    // a min-heap of the next kept element of every source, merging all of them in a single pass
+    typedef std::pair<ElementId, size_t> HeapEntry;
+    std::vector<HeapEntry> heap;
+    heap.reserve(sources.size());
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (sources[i].position != sources[i].elements->end()) {
+            heap.emplace_back(*sources[i].position, i);
+        }
+    }
+    std::make_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+
+    std::vector<ElementId> differingElements;
+    std::vector<size_t> keptBy;
+    keptBy.reserve(sources.size());
+    while (!heap.empty()) {
+        ElementId element = heap.front().first;
+        keptBy.clear();
+        while (!heap.empty() && heap.front().first == element) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+            size_t i = heap.back().second;
+            heap.pop_back();
+            keptBy.push_back(i);
+            if (++sources[i].position != sources[i].elements->end()) {
+                heap.emplace_back(*sources[i].position, i);
+                std::push_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+            }
+        }
+
+        // a source contains the element if it is a finite source keeping it, or an infinite source not keeping it in its complement
+        for (auto i : keptBy) {
+            if (i < operandCount) {
+                operandMembership[i] = !sources[i].infinite;
+            } else {
+                parentMembership = !sources[i].infinite;
+            }
+        }
+        if (evaluate(program_, operandMembership, parentMembership) != background) {
+            differingElements.push_back(element);
+        }
+        for (auto i : keptBy) {
+            if (i < operandCount) {
+                operandMembership[i] = sources[i].infinite;
+            } else {
+                parentMembership = sources[i].infinite;
+            }
+        }
+    }
+
+    // when every element outside of the sources is in the result, it is infinite and the differing elements are its complement
+    assign({background, ElementSet(std::move(differingElements))});
+}
+
+bool ExpressionSet::derives(ElementId element) const noexcept {
+    if (program_.empty() || operandCount_ != derivesFrom().size()) {
+        return false;
+    }
+    std::vector<char> operandMembership;
+    operandMembership.reserve(derivesFrom().size());
+    for (const auto* userSet : derivesFrom()) {
+        operandMembership.push_back(userSet->contains(element));
+    }
+    return evaluate(program_, operandMembership, parent()->contains(element));
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+/*
+    expression-set.hpp
+    Expression set is a derivative set that holds the result of a boolean expression over already existing subsets of its parent, such as (A | B) & ~C ^ D
+
+    The expression is compiled once into a postfix program, which is then evaluated for every element of its operands in a single merged pass over them,
+    so none of the intermediate sets of the expression are ever built
+*/
+#pragma once
+
+#include "derivative-set.hpp"
+
+class ExpressionSet : public DerivativeSet {
+    public:
+        struct Instruction {
+            enum Operation : char {
+                PUSH_OPERAND = 'o',
+                PUSH_PARENT = 'p',
+                INTERSECT = '&',
+                UNITE = '|',
+                DIFFERENCE = '-',
+                SYMMETRIC_DIFFERENCE = '^'
+            };
+            Operation operation;
+            // the index in derivesFrom of the operand pushed by PUSH_OPERAND
+            uint32_t operand;
+        };
+
+        ExpressionSet(UserSet* parent, const std::string& name, std::vector<UserSet*> userSets, std::string expression, std::vector<Instruction> program) noexcept;
+        ExpressionSet(UserSet* parent, const std::string& name) noexcept;
+
+        // #region SubSet public members override
+        static UserSet* createSet(UserSet& parent, const std::string& name) noexcept;
+        // #endregion
+        // #region UserSet public members override
+        static constexpr char type_ = 'E';
+        char type() const noexcept override { return type_; }
+        void updateElements() noexcept override;
+        // #endregion
+        // #region DerivativeSet public members override
+        void saveMachineDerivativeSubset(MachineWriter& saveLocation) noexcept override;
+        void loadMachineDerivativeSubset(MachineReader& loadLocation) noexcept override;
+        void postPostSiblingsLoad() noexcept(false) override;
+        bool derives(ElementId element) const noexcept override;
+        // #endregion
+
+        void printExpression() noexcept;
+
+        // compiles expression into a postfix program, with its operands numbered in the order their names first appear in operandNames
+        // the operators, from tightest to loosest binding, are ~ (relative complement to the parent), & and - (intersection and difference), ^ (symmetric difference), and | (union)
+        // names that contain spaces or operator characters can be wrapped in double quotes
+        // returns false and describes the problem in error if expression is not valid
+        static bool compile(const std::string& expression, std::vector<Instruction>& program, std::vector<std::string>& operandNames, std::string& error) noexcept;
+
+        // programs deeper than this cannot be evaluated
+        static constexpr size_t MAX_STACK_DEPTH = 64;
+    private:
+        // #region UserSet private members override
+        const Menu<UserSet, void>& setSpecificMenu() const noexcept override;
+        // #endregion
+
+        std::string expression_;
+        std::vector<Instruction> program_;
+        // the number of operands the expression names, which must match derivesFrom once it is loaded
+        size_t operandCount_ = 0;
+};
\ No newline at end of file
@@ -16,10 +16,16 @@
 
 FauxWordSet::FauxWordSet(WordSet&& wordSet) noexcept 
     : SubSet(wordSet.parent(), std::string(wordSet.name()), std::move(wordSet.elements_))
-{}
+{
+    takeOverConnections(wordSet);
+    index_->erase(&wordSet, *elements_);
+    index_->insert(this, *elements_);
+    // the words the parent lacks become faux
+    updateElements();
+}
 
 FauxWordSet::FauxWordSet(UserSet* parent, const std::string& name) noexcept
-    : SubSet(parent, name, std::make_unique<std::set<std::string>>())
+    : SubSet(parent, name, std::make_unique<ElementSet>())
 {}
 
 UserSet* FauxWordSet::createSet(UserSet& parent, const std::string& name) noexcept {
@@ -31,6 +37,7 @@ const auto FAUX_WORD_SET_MENU = ReinterpretMenu<FauxWordSet, UserSet, void>({
     {"AX", {"Add a word from the parent set", &FauxWordSet::addParentWord}},
     {"R", {"Remove a word", &FauxWordSet::removeWord}},
     {"RX", {"Remove a word by number in this set", &FauxWordSet::removeContainedWord}},
+    {"I", {"Import words from a file", &FauxWordSet::importWords}},
     {"LE", {"List faux elements", &FauxWordSet::listFauxElements}},
     {"X", {"Exit set-specific options", &FauxWordSet::exitSetSpecificOptions}},
     {std::string(UserSet::EXIT_KEYWORD), {"Exit the program", &FauxWordSet::exitProgram}}
@@ -46,7 +53,7 @@ void FauxWordSet::addWord() noexcept {
     ignoreAll(nowide::cin);;
     std::getline(nowide::cin, word);
 
-    auto inserted = addElement(word);
+    auto inserted = addElement(dictionary().intern(word));
     if (!inserted) {
         nowide::cout << "That word was already in the set and was therefore not inserted\n";
     }
@@ -57,13 +64,14 @@ void FauxWordSet::addParentWord() noexcept {
         nowide::cout << "The parent has an infinite set of elements and cannot be specified from\n";
         return;
     }
+    auto parentElements = dictionary().sorted(*parent()->elements());
     int count = 0;
-    for (const auto& element : *parent()->elements()) {
+    for (auto element : parentElements) {
         if (contains(element)) {
             continue;
         }
         ++count;
-        nowide::cout << count << ". '" << element << "'\n";
+        nowide::cout << count << ". '" << dictionary().element(element) << "'\n";
     }
 
     int selection = 0;
@@ -74,7 +82,7 @@ void FauxWordSet::addParentWord() noexcept {
     }
     
     count = 0;
-    for (const auto& element : *parent()->elements()) {
+    for (auto element : parentElements) {
         if (contains(element)) {
             continue;
         }
@@ -94,19 +102,25 @@ void FauxWordSet::removeWord() noexcept {
     ignoreAll(nowide::cin);;
     std::getline(nowide::cin, word);
 
-    removedElement(word, true);
+    ElementId element;
+    if (!dictionary().find(word, element)) {
+        return;
+    }
+    removedElement(element, true);
+    changed({{}, {element}});
 }
 
 void FauxWordSet::removeContainedWord() noexcept {
-    if (fauxElements.size() == 0) {
+    if (fauxElements.size() == 0 && elements_->size() == 0) {
         nowide::cout << "There are no fauxElements to select from to remove.\n";
         return;
     }
 
+    auto sortedFauxElements = dictionary().sorted(words());
     int count = 0;
-    for (const auto& element : fauxElements) {
+    for (auto element : sortedFauxElements) {
         ++count;
-        nowide::cout << count << ". '" << element << "'\n";
+        nowide::cout << count << ". '" << dictionary().element(element) << "'\n";
     }
 
     int selection = 0;
@@ -117,10 +131,11 @@ void FauxWordSet::removeContainedWord() noexcept {
     }
 
     count = 0;
-    for (const auto& element : fauxElements) {
+    for (auto element : sortedFauxElements) {
         ++count;
         if (count == selection) {
             removedElement(element, true);
+            changed({{}, {element}});
             return;
         }
     }
@@ -128,60 +143,121 @@ void FauxWordSet::removeContainedWord() noexcept {
     exitProgram();
 }
 
+void FauxWordSet::importWords() noexcept {
+    ElementSet words;
+    size_t unknownWords = 0;
+    if (!queryImportedWords(words, true, unknownWords)) {
+        return;
+    }
+    auto addedWords = ElementSet::difference(words, this->words());
+    // only the words the parent has are elements, the rest stay faux until the parent gains them
+    auto parentWords = applySetOperation<SetOperation::INTERSECT>(SetView{false, &addedWords}, parent()->view()).stored;
+    insertStored(*elements_, parentWords);
+    insertStored(fauxElements, ElementSet::difference(addedWords, parentWords));
+    changed({std::vector<ElementId>(parentWords.begin(), parentWords.end()), {}});
+
+    nowide::cout << "Imported " << addedWords.size() << " words, of which " << parentWords.size() << " are in the parent set, and "
+              << words.size() - addedWords.size() << " were already in the set\n";
+}
+
 void FauxWordSet::listFauxElements() noexcept {
     nowide::cout << "Element list\n"
               << std::string(80, '-') << '\n'
               << "This set contains faux elements:\n";
-    for (const auto& element : fauxElements) {
-        nowide::cout << '\'' << element << "'\n";
+    for (auto element : dictionary().sorted(words())) {
+        nowide::cout << '\'' << dictionary().element(element) << "'\n";
     }
     nowide::cout << std::string(80, '-') << '\n';
 }
 
-void FauxWordSet::saveMachineSubset(std::ostream& saveLocation) noexcept {
-    saveLocation << fauxElements.size();
-    for (const auto& element : fauxElements) {
-        saveLocation << ' ' << element.size() << ' ' << element;
-    }
+void FauxWordSet::saveMachineSubset(MachineWriter& saveLocation) noexcept {
+    saveLocation.writeElements(words());
 }
 
-void FauxWordSet::loadMachineSubset(std::istream& loadLocation) noexcept {
-    size_t elementCount;
-    loadLocation >> elementCount;
-    for (; elementCount > 0; --elementCount) {
-        size_t elementSize;
-        loadLocation >> elementSize;
-        // pre-creates a string of elementSize to read into
-        std::string element;
-        element.resize(elementSize);
-        // skips over the space after size
-        skipRead(loadLocation, 1);
-        // reads all of the text into the element
-        loadLocation.read(element.data(), elementSize);
-        fauxElements.emplace(std::move(element));
-    }
+void FauxWordSet::loadMachineSubset(MachineReader& loadLocation) noexcept {
+    // every word is faux until the parent is loaded and this set is computed from it
+    fauxElements = ElementSet(loadLocation.readElements());
+    index_->insert(this, fauxElements);
 }
 
 void FauxWordSet::updateElements() noexcept {
-    elements_->clear();
-    auto* parentElements = parent()->elements();
-    if (parentElements != nullptr) {
-        std::set_intersection(fauxElements.begin(), fauxElements.end(), parentElements->begin(), parentElements->end(), std::inserter(*elements_, elements_->begin()));
-    } else {
-        auto* parentComplementElements = parent()->complementElements();
-        std::set_difference(fauxElements.begin(), fauxElements.end(), parentComplementElements->begin(), parentComplementElements->end(), std::inserter(*elements_, elements_->begin()));
-    }
-} 
-
-bool FauxWordSet::addElement(const std::string& element) noexcept {
-    bool added = fauxElements.insert(element).second;
-    updateElements();
+    // the words only move between the elements and the faux elements, so the element index is unaffected
+    auto words = this->words();
+    *elements_ = applySetOperation<SetOperation::INTERSECT>(SetView{false, &words}, parent()->view()).stored;
+    fauxElements = ElementSet::difference(words, *elements_);
+}
+
+ElementSet FauxWordSet::words() const noexcept {
+    return ElementSet::unite(fauxElements, *elements_);
+}
+
+bool FauxWordSet::addElement(ElementId element) noexcept {
+    if (fauxElements.contains(element)) {
+        return false;
+    }
+    // the element is only one of the elements if the parent has it, otherwise it stays faux until the parent gains it
+    if (!parent()->contains(element)) {
+        return insertStored(fauxElements, element);
+    }
+    bool added = insertStored(*elements_, element);
+    if (added) {
+        changed({{element}, {}});
+    }
     return added;
 }
 
-void FauxWordSet::removedElement(const std::string& element, bool expected) noexcept {
-    for (const auto& subset : subsets_) {
-        subset.second->removedElement(element, expected);
+void FauxWordSet::removedElements(const ElementSet& elements, bool expected) noexcept {
+    removedFromSubsets(elements, expected);
+    eraseStored(fauxElements, elements);
+    eraseStored(*elements_, elements);
+}
+
+ElementDelta FauxWordSet::applyDelta(const ElementDelta& inputDelta) noexcept {
+    if (inputDelta.unbounded) {
+        return SubSet::applyDelta(inputDelta);
+    }
+    ElementDelta delta;
+    // faux elements the parent gained become elements, and elements the parent lost become faux again,
+    // each moving a single word between the two, which leaves the element index as it is
+    for (auto element : inputDelta.added) {
+        if (parent()->contains(element) && fauxElements.erase(element)) {
+            elements_->insert(element);
+            delta.added.push_back(element);
+        }
+    }
+    for (auto element : inputDelta.removed) {
+        if (!parent()->contains(element) && elements_->erase(element)) {
+            fauxElements.insert(element);
+            delta.removed.push_back(element);
+        }
+    }
+    return delta;
+}
+
+std::vector<const ElementSet*> FauxWordSet::indexedElements() const noexcept {
+    return {&fauxElements, elements_.get()};
+}
+
+void FauxWordSet::replayEdit(ElementId element, bool inserted) noexcept {
+    // every word is faux until this set is computed from its parent, as when it is loaded
+    if (inserted) {
+        if (!elements_->contains(element)) {
+            insertStored(fauxElements, element);
+        }
+        return;
+    }
+    ElementSet erased(std::vector<ElementId>{element});
+    eraseStored(fauxElements, erased);
+    eraseStored(*elements_, erased);
+}
+
+void FauxWordSet::undoEdit(ElementSet& elements, ElementId element, bool inserted) noexcept {
+    if (!inserted) {
+        SubSet::undoEdit(elements, element, inserted);
+        return;
     }
-    fauxElements.erase(element);
+    // a word may have moved between the elements and the faux elements since it was inserted
+    ElementSet erased(std::vector<ElementId>{element});
+    eraseStored(fauxElements, erased);
+    eraseStored(*elements_, erased);
 }
\ No newline at end of file
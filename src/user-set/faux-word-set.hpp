@@ -23,25 +23,39 @@ class FauxWordSet : public SubSet {
         static constexpr char type_ = 'F';
         char type() const noexcept override  { return type_; }
 
-        void saveMachineSubset(std::ostream& saveLocation) noexcept override;
-        void loadMachineSubset(std::istream& loadLocation) noexcept override;
+        void saveMachineSubset(MachineWriter& saveLocation) noexcept override;
+        void loadMachineSubset(MachineReader& loadLocation) noexcept override;
         void updateElements() noexcept override;
+        ElementDelta applyDelta(const ElementDelta& inputDelta) noexcept override;
+        // both the elements and the faux elements, which together are every word of this set
+        std::vector<const ElementSet*> indexedElements() const noexcept override;
         // #endregion 
 
         void addWord() noexcept;
         void addParentWord() noexcept;
         void removeWord() noexcept;
         void removeContainedWord() noexcept;
+        void importWords() noexcept;
         void listFauxElements() noexcept;
 
-        bool addElement(const std::string& element) noexcept;
-        void removedElement(const std::string& element, bool expected) noexcept override;
+        bool addElement(ElementId element) noexcept;
+        void removedElements(const ElementSet& elements, bool expected) noexcept override;
+    protected:
+        // #region UserSet protected members override
+        void undoEdit(ElementSet& elements, ElementId element, bool inserted) noexcept override;
+        void replayEdit(ElementId element, bool inserted) noexcept override;
+        // #endregion
     private:
         // #region UserSet private members override 
         const Menu<UserSet, void>& setSpecificMenu() const noexcept override;
         // #endregion 
 
-        std::set<std::string> fauxElements;
+        // every word of this set, whether or not the parent has it
+        ElementSet words() const noexcept;
+
+        // the words of this set that the parent does not have, where every word the parent has is one of the elements instead,
+        // so that each word is stored once, and moves between the two as the parent gains or loses it
+        ElementSet fauxElements;
 
         friend class WordSet;
 };
\ No newline at end of file
@@ -14,24 +14,44 @@
 #include "difference-set.hpp"
 #include "symmetric-difference-set.hpp"
 #include "relative-complement-set.hpp"
+#include "expression-set.hpp"
 
 GlobalSet::GlobalSet()
-    : UserSet(std::make_unique<std::set<std::string>>())
+    : UserSet(&elementDictionary_, &elementIndex_, &editTransaction_, &editJournal_, &threadPool_, std::make_unique<ElementSet>()), editJournal_(elementDictionary_)
 {}
 
 std::string_view GlobalSet::name() const noexcept {
     return "GLOBAL";
 }
 
-void GlobalSet::saveMachineSubset(std::ostream&) noexcept {
+void GlobalSet::saveMachineSubset(MachineWriter&) noexcept {
 }
 
-void GlobalSet::loadMachineSubset(std::istream&) noexcept {
+void GlobalSet::loadMachineSubset(MachineReader&) noexcept {
 }
 
 void GlobalSet::updateElements() noexcept {
 }
 
+const auto GLOBAL_SET_MENU = ReinterpretMenu<GlobalSet, UserSet, void>({
+    {"I", {"Toggle whether or not the sets that contain each element are indexed", &GlobalSet::toggleElementIndex}},
+    {"X", {"Exit set-specific options", &GlobalSet::exitSetSpecificOptions}},
+    {std::string(UserSet::EXIT_KEYWORD), {"Exit the program", &GlobalSet::exitProgram}}
+});
+
+const Menu<UserSet, void>& GlobalSet::setSpecificMenu() const noexcept {
+    return GLOBAL_SET_MENU;
+}
+
+void GlobalSet::toggleElementIndex() noexcept {
+    if (elementIndex_.enabled()) {
+        elementIndex_.disable();
+    } else {
+        elementIndex_.enable(*this);
+    }
+    nowide::cout << "Indexing of the sets that contain each element was turned " << (elementIndex_.enabled() ? "on" : "off") << ".\n";
+}
+
 const auto GLOBAL_CREATEABLE_SUBSET_MENU = StaticMenu<void, UserSet*, UserSet&, const std::string&>({
     {std::string(1, WordSet::type_), {"WordSet", WordSet::createSet}},
     {std::string(1, FauxWordSet::type_), {"FauxWordSet", FauxWordSet::createSet}},
@@ -41,6 +61,7 @@ const auto GLOBAL_CREATEABLE_SUBSET_MENU = StaticMenu<void, UserSet*, UserSet&,
     {std::string(1, DifferenceSet::type_), {"DifferenceSet", DifferenceSet::createSet}},
     {std::string(1, SymmetricDifferenceSet::type_), {"SymmetricDifferenceSet", SymmetricDifferenceSet::createSet}},
     {std::string(1, RelativeComplementSet::type_), {"RelativeComplementSet", RelativeComplementSet::createSet}},
+    {std::string(1, ExpressionSet::type_), {"ExpressionSet", ExpressionSet::createSet}},
     {std::string(UserSet::EXIT_KEYWORD), {"Exit", UserSet::EXIT_SET_MENU}}
 });
 
@@ -17,10 +17,22 @@ class GlobalSet : public UserSet {
         static constexpr char type_ = 'G';
         char type() const noexcept override { return type_; }
 
-        void saveMachineSubset(std::ostream& saveLocation) noexcept override;
-        void loadMachineSubset(std::istream& loadLocation) noexcept override;
+        void saveMachineSubset(MachineWriter& saveLocation) noexcept override;
+        void loadMachineSubset(MachineReader& loadLocation) noexcept override;
         void updateElements() noexcept override;
         // #endregion
+
+        void toggleElementIndex() noexcept;
     private:
+        // #region UserSet private members override
+        const Menu<UserSet, void>& setSpecificMenu() const noexcept override;
+        // #endregion
+
+        ElementDictionary elementDictionary_;
+        ElementIndex elementIndex_;
+        EditTransaction editTransaction_;
+        EditJournal editJournal_;
+        ThreadPool threadPool_;
+
         const Menu<void, UserSet*, UserSet&, const std::string&>& createableSubsetMenu() const noexcept override;
 };
\ No newline at end of file
@@ -0,0 +1,470 @@
+/*
+    machine-format.cpp
+
+    MachineWriter and MachineReader are how every set saves and loads itself in the machine format, independently of its encoding
+    A saved hierarchy is a record per set, holding its type, whether it is included in human readable output, its name, and a section with whatever the type saves,
+    followed by the records of its subsets and an end marker
+
+    The binary encoding is what sets are saved as, starting with a magic number and a version, followed by a section with every saved element string,
+    so that records refer to elements by their position in it as varints, and every section is prefixed by its length
+    The text encoding is the original one, of decimal sizes each followed by a space and the string they are the size of, which is kept for import and export
+*/
+#include "machine-format.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cctype>
+
+namespace {
+    // the first byte cannot start the text encoding, which starts with the type of a set
+    constexpr std::string_view MAGIC = "\x89SET";
+    constexpr size_t VERSION = 1;
+    // the most a binary writer holds before writing it out, once no section is unfinished
+    constexpr size_t FLUSH_SIZE = 1 << 20;
+    constexpr size_t READ_SIZE = 1 << 20;
+
+    void appendVarint(std::string& buffer, size_t value) noexcept {
+        while (value >= 0x80) {
+            buffer.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        buffer.push_back(static_cast<char>(value));
+    }
+
+    std::string readAll(std::istream& loadLocation) noexcept {
+        std::string data;
+        while (loadLocation) {
+            auto size = data.size();
+            data.resize(size + READ_SIZE);
+            loadLocation.read(data.data() + size, READ_SIZE);
+            data.resize(size + loadLocation.gcount());
+        }
+        return data;
+    }
+}
+
+const std::string& MachineReader::error() const noexcept {
+    return error_;
+}
+
+void MachineReader::fail(std::string error) noexcept {
+    // the first error is what made everything after it unreadable
+    if (error_.empty()) {
+        error_ = std::move(error);
+    }
+}
+
+bool isBinaryMachineFormat(std::istream& loadLocation) noexcept {
+    return loadLocation.peek() == static_cast<unsigned char>(MAGIC[0]);
+}
+
+bool isBinaryMachineFormat(std::string_view loadLocation) noexcept {
+    return !loadLocation.empty() && loadLocation[0] == MAGIC[0];
+}
+
+TextMachineWriter::TextMachineWriter(std::ostream& saveLocation, const ElementDictionary& dictionary) noexcept
+    : saveLocation_(saveLocation), dictionary_(dictionary)
+{}
+
+void TextMachineWriter::beginSet(char type, bool humanIncluded, std::string_view name) noexcept {
+    saveLocation_ << type << ' ' << humanIncluded << ' ' << name.size() << ' ' << name << ' ';
+    sectionStart_ = true;
+}
+
+void TextMachineWriter::endSet() noexcept {
+    saveLocation_ << '\n';
+}
+
+void TextMachineWriter::endSubsets() noexcept {
+    saveLocation_ << "0\n";
+}
+
+void TextMachineWriter::separate() noexcept {
+    if (!sectionStart_) {
+        saveLocation_ << ' ';
+    }
+    sectionStart_ = false;
+}
+
+void TextMachineWriter::writeSize(size_t size) noexcept {
+    separate();
+    saveLocation_ << size;
+}
+
+void TextMachineWriter::writeString(std::string_view string) noexcept {
+    separate();
+    saveLocation_ << string.size() << ' ' << string;
+}
+
+void TextMachineWriter::writeElements(const ElementSet& elements) noexcept {
+    writeSize(elements.size());
+    for (auto element : elements) {
+        writeString(dictionary_.element(element));
+    }
+}
+
+TextMachineReader::TextMachineReader(std::istream& loadLocation, ElementDictionary& dictionary) noexcept
+    : loadLocation_(&loadLocation), dictionary_(dictionary)
+{}
+
+TextMachineReader::TextMachineReader(std::shared_ptr<const MappedFile> loadLocation, ElementDictionary& dictionary) noexcept
+    : mappedFile_(std::move(loadLocation)), dictionary_(dictionary), data_(mappedFile_->contents())
+{
+    dictionary.retain(mappedFile_);
+}
+
+bool TextMachineReader::fill(size_t count) noexcept {
+    if (data_.size() - position_ >= count) {
+        return true;
+    }
+    if (loadLocation_ == nullptr) {
+        return false;
+    }
+    // only what is not parsed yet is kept, at the start of the buffer
+    buffer_.erase(0, position_);
+    position_ = 0;
+    // a record at a time is read, which is all of a line, so that nothing after the saved sets is read from the stream,
+    // and so that a size is never split between what is read and what is not
+    std::string line;
+    while (buffer_.size() < count && std::getline(*loadLocation_, line)) {
+        buffer_.append(line);
+        if (!loadLocation_->eof()) {
+            buffer_.push_back('\n');
+        }
+    }
+    data_ = buffer_;
+    return buffer_.size() >= count;
+}
+
+void TextMachineReader::skipSpaces() noexcept {
+    do {
+        while (position_ < data_.size() && std::isspace(static_cast<unsigned char>(data_[position_]))) {
+            ++position_;
+        }
+    } while (position_ == data_.size() && fill(1));
+}
+
+bool TextMachineReader::beginSet(char& type, bool& humanIncluded, std::string& name) noexcept {
+    if (!error().empty()) {
+        return false;
+    }
+    skipSpaces();
+    if (!fill(1)) {
+        fail("the saved sets end before all of their records do");
+        return false;
+    }
+    type = data_[position_++];
+    if (type == '0') {
+        return false;
+    }
+    humanIncluded = readSize() != 0;
+    name = readString();
+    return error().empty();
+}
+
+void TextMachineReader::endSet() noexcept {
+}
+
+size_t TextMachineReader::readSize() noexcept {
+    if (!error().empty()) {
+        return 0;
+    }
+    skipSpaces();
+    size_t size = 0;
+    auto [end, error] = std::from_chars(data_.data() + position_, data_.data() + data_.size(), size);
+    if (error != std::errc()) {
+        fail("a size in the saved sets is not a number");
+        return 0;
+    }
+    position_ = end - data_.data();
+    return size;
+}
+
+std::string_view TextMachineReader::readString() noexcept {
+    auto size = readSize();
+    // the size is followed by a single space before the string
+    if (!error().empty() || !fill(size + 1)) {
+        fail("the saved sets end in the middle of a string");
+        return {};
+    }
+    std::string_view string = data_.substr(position_ + 1, size);
+    position_ += size + 1;
+    return string;
+}
+
+std::vector<ElementId> TextMachineReader::readElements() noexcept {
+    std::vector<ElementId> elements;
+    for (auto count = readSize(); count > 0 && error().empty(); --count) {
+        auto element = readString();
+        // element strings are only copied if they are not in a mapped file, which the dictionary retains
+        elements.push_back(mappedFile_ ? dictionary_.internView(element) : dictionary_.intern(element));
+    }
+    return elements;
+}
+
+bool TextMachineReader::atEnd() noexcept {
+    skipSpaces();
+    return !fill(1);
+}
+
+MachineElementCollector::MachineElementCollector(const ElementDictionary& dictionary) noexcept
+    : written_(dictionary.size())
+{}
+
+void MachineElementCollector::writeElements(const ElementSet& elements) noexcept {
+    for (auto element : elements) {
+        written_[element] = true;
+    }
+}
+
+std::vector<ElementId> MachineElementCollector::elements() const noexcept {
+    std::vector<ElementId> elements;
+    for (ElementId element = 0; element < written_.size(); ++element) {
+        if (written_[element]) {
+            elements.push_back(element);
+        }
+    }
+    return elements;
+}
+
+void MachineRecording::beginSet(char type, bool humanIncluded, std::string_view name) noexcept {
+    records_.push_back({Call::BEGIN_SET, strings_.size(), type, humanIncluded});
+    strings_.emplace_back(name);
+}
+
+void MachineRecording::endSet() noexcept {
+    records_.push_back({Call::END_SET, 0, 0, false});
+}
+
+void MachineRecording::endSubsets() noexcept {
+    records_.push_back({Call::END_SUBSETS, 0, 0, false});
+}
+
+void MachineRecording::writeSize(size_t size) noexcept {
+    records_.push_back({Call::WRITE_SIZE, size, 0, false});
+}
+
+void MachineRecording::writeString(std::string_view string) noexcept {
+    records_.push_back({Call::WRITE_STRING, strings_.size(), 0, false});
+    strings_.emplace_back(string);
+}
+
+void MachineRecording::writeElements(const ElementSet& elements) noexcept {
+    records_.push_back({Call::WRITE_ELEMENTS, elements_.size(), 0, false});
+    elements_.push_back(elements);
+}
+
+void MachineRecording::replay(MachineWriter& saveLocation) const noexcept {
+    for (const auto& record : records_) {
+        switch (record.call) {
+            case Call::BEGIN_SET:
+                saveLocation.beginSet(record.type, record.humanIncluded, strings_[record.value]);
+                break;
+            case Call::END_SET:
+                saveLocation.endSet();
+                break;
+            case Call::END_SUBSETS:
+                saveLocation.endSubsets();
+                break;
+            case Call::WRITE_SIZE:
+                saveLocation.writeSize(record.value);
+                break;
+            case Call::WRITE_STRING:
+                saveLocation.writeString(strings_[record.value]);
+                break;
+            case Call::WRITE_ELEMENTS:
+                saveLocation.writeElements(elements_[record.value]);
+                break;
+        }
+    }
+}
+
+BinaryMachineWriter::BinaryMachineWriter(std::ostream& saveLocation, const ElementDictionary& dictionary, const std::vector<ElementId>& savedElements) noexcept
+    : saveLocation_(saveLocation), positions_(dictionary.size())
+{
+    buffer_.append(MAGIC);
+    appendVarint(buffer_, VERSION);
+    beginSection();
+    writeSize(savedElements.size());
+    for (ElementId position = 0; position < savedElements.size(); ++position) {
+        positions_[savedElements[position]] = position;
+        writeString(dictionary.element(savedElements[position]));
+    }
+    endSection();
+}
+
+BinaryMachineWriter::~BinaryMachineWriter() noexcept {
+    flush();
+}
+
+void BinaryMachineWriter::beginSet(char type, bool humanIncluded, std::string_view name) noexcept {
+    buffer_.push_back(type);
+    buffer_.push_back(humanIncluded);
+    writeString(name);
+    beginSection();
+}
+
+void BinaryMachineWriter::endSet() noexcept {
+    endSection();
+    if (buffer_.size() >= FLUSH_SIZE) {
+        flush();
+    }
+}
+
+void BinaryMachineWriter::endSubsets() noexcept {
+    buffer_.push_back('\0');
+}
+
+void BinaryMachineWriter::writeSize(size_t size) noexcept {
+    appendVarint(buffer_, size);
+}
+
+void BinaryMachineWriter::writeString(std::string_view string) noexcept {
+    appendVarint(buffer_, string.size());
+    buffer_.append(string);
+}
+
+void BinaryMachineWriter::writeElements(const ElementSet& elements) noexcept {
+    appendVarint(buffer_, elements.size());
+    // the positions increase along with the ids, so each is saved as how far it is past the one before it
+    ElementId previous = 0;
+    for (auto element : elements) {
+        appendVarint(buffer_, positions_[element] - previous);
+        previous = positions_[element];
+    }
+}
+
+void BinaryMachineWriter::beginSection() noexcept {
+    sectionStart_ = buffer_.size();
+}
+
+void BinaryMachineWriter::endSection() noexcept {
+    std::string length;
+    appendVarint(length, buffer_.size() - sectionStart_);
+    buffer_.insert(sectionStart_, length);
+}
+
+void BinaryMachineWriter::flush() noexcept {
+    saveLocation_.write(buffer_.data(), buffer_.size());
+    buffer_.clear();
+}
+
+BinaryMachineReader::BinaryMachineReader(std::istream& loadLocation, ElementDictionary& dictionary) noexcept
+    : loadedData_(readAll(loadLocation)), data_(loadedData_), end_(data_.size())
+{
+    readHeader(dictionary);
+}
+
+BinaryMachineReader::BinaryMachineReader(std::shared_ptr<const MappedFile> loadLocation, ElementDictionary& dictionary) noexcept
+    : mappedFile_(std::move(loadLocation)), data_(mappedFile_->contents()), end_(data_.size())
+{
+    dictionary.retain(mappedFile_);
+    readHeader(dictionary);
+}
+
+void BinaryMachineReader::readHeader(ElementDictionary& dictionary) noexcept {
+    if (data_.substr(0, MAGIC.size()) != MAGIC) {
+        fail("the saved sets are not in the binary format");
+        return;
+    }
+    position_ = MAGIC.size();
+    auto version = readSize();
+    if (error().empty() && version != VERSION) {
+        fail("the saved sets are in version " + std::to_string(version) + " of the binary format, which is not supported");
+        return;
+    }
+    beginSection();
+    auto count = readSize();
+    // every element string takes at least a byte, which keeps a corrupt count from reserving more than there is
+    ids_.reserve(std::min(count, end_ - position_));
+    dictionary.reserve(ids_.capacity());
+    for (; count > 0 && error().empty(); --count) {
+        // element strings are only copied if they are not in a mapped file, which the dictionary retains
+        ids_.push_back(mappedFile_ ? dictionary.internView(readString()) : dictionary.intern(readString()));
+    }
+    endSection();
+}
+
+uint8_t BinaryMachineReader::readByte() noexcept {
+    if (!error().empty()) {
+        return 0;
+    }
+    if (position_ >= end_) {
+        fail("the saved sets end in the middle of a section");
+        return 0;
+    }
+    return static_cast<uint8_t>(data_[position_++]);
+}
+
+bool BinaryMachineReader::beginSet(char& type, bool& humanIncluded, std::string& name) noexcept {
+    type = static_cast<char>(readByte());
+    if (type == '\0' || !error().empty()) {
+        return false;
+    }
+    humanIncluded = readByte() != 0;
+    name = readString();
+    beginSection();
+    return error().empty();
+}
+
+void BinaryMachineReader::endSet() noexcept {
+    endSection();
+}
+
+size_t BinaryMachineReader::readSize() noexcept {
+    size_t size = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        auto byte = readByte();
+        size |= static_cast<size_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return size;
+        }
+    }
+    fail("a size in the saved sets is too large");
+    return 0;
+}
+
+std::string_view BinaryMachineReader::readString() noexcept {
+    auto size = readSize();
+    if (size > end_ - position_) {
+        fail("a string in the saved sets is longer than the section it is in");
+        return {};
+    }
+    std::string_view string(data_.data() + position_, size);
+    position_ += size;
+    return string;
+}
+
+std::vector<ElementId> BinaryMachineReader::readElements() noexcept {
+    std::vector<ElementId> elements;
+    auto count = readSize();
+    // every element takes at least a byte, which keeps a corrupt count from reserving more than there is
+    elements.reserve(std::min(count, end_ - position_));
+    size_t position = 0;
+    for (; count > 0 && error().empty(); --count) {
+        position += readSize();
+        if (position >= ids_.size()) {
+            fail("an element in the saved sets is not one of the saved element strings");
+            return {};
+        }
+        elements.push_back(ids_[position]);
+    }
+    return elements;
+}
+
+void BinaryMachineReader::beginSection() noexcept {
+    auto length = readSize();
+    if (length > end_ - position_) {
+        fail("a section of the saved sets is longer than what is left of them");
+        return;
+    }
+    end_ = position_ + length;
+}
+
+void BinaryMachineReader::endSection() noexcept {
+    if (error().empty() && position_ != end_) {
+        fail("a section of the saved sets holds more than its set saves");
+    }
+    position_ = end_;
+    end_ = data_.size();
+}
\ No newline at end of file
@@ -0,0 +1,236 @@
+/*
+    machine-format.hpp
+
+    MachineWriter and MachineReader are how every set saves and loads itself in the machine format, independently of its encoding
+    A saved hierarchy is a record per set, holding its type, whether it is included in human readable output, its name, and a section with whatever the type saves,
+    followed by the records of its subsets and an end marker
+
+    The binary encoding is what sets are saved as, starting with a magic number and a version, followed by a section with every saved element string,
+    so that records refer to elements by their position in it as varints, and every section is prefixed by its length
+    The text encoding is the original one, of decimal sizes each followed by a space and the string they are the size of, which is kept for import and export
+*/
+#pragma once
+
+#include "element-set.hpp"
+#include "element-dictionary.hpp"
+#include "platform.hpp"
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+
+class MachineWriter {
+    public:
+        virtual ~MachineWriter() noexcept = default;
+
+        // starts the record of a set, which is ended before the records of its subsets
+        virtual void beginSet(char type, bool humanIncluded, std::string_view name) noexcept = 0;
+        virtual void endSet() noexcept = 0;
+        // ends the records of the subsets of the set whose record came before them
+        virtual void endSubsets() noexcept = 0;
+
+        virtual void writeSize(size_t size) noexcept = 0;
+        virtual void writeString(std::string_view string) noexcept = 0;
+        virtual void writeElements(const ElementSet& elements) noexcept = 0;
+};
+
+class MachineReader {
+    public:
+        virtual ~MachineReader() noexcept = default;
+
+        // starts the record of a set, returning false instead once the records of the subsets of a set have ended
+        virtual bool beginSet(char& type, bool& humanIncluded, std::string& name) noexcept = 0;
+        virtual void endSet() noexcept = 0;
+
+        virtual size_t readSize() noexcept = 0;
+        // the string stays valid until the next read
+        virtual std::string_view readString() noexcept = 0;
+        // the elements, interned into the dictionary, in no particular order
+        virtual std::vector<ElementId> readElements() noexcept = 0;
+
+        // why what was read is malformed, which is empty unless it is, after which everything read is empty
+        const std::string& error() const noexcept;
+    protected:
+        void fail(std::string error) noexcept;
+    private:
+        std::string error_;
+};
+
+// detects which encoding loadLocation is in from its first byte
+bool isBinaryMachineFormat(std::istream& loadLocation) noexcept;
+bool isBinaryMachineFormat(std::string_view loadLocation) noexcept;
+
+class TextMachineWriter : public MachineWriter {
+    public:
+        TextMachineWriter(std::ostream& saveLocation, const ElementDictionary& dictionary) noexcept;
+
+        // #region MachineWriter public members override
+        void beginSet(char type, bool humanIncluded, std::string_view name) noexcept override;
+        void endSet() noexcept override;
+        void endSubsets() noexcept override;
+        void writeSize(size_t size) noexcept override;
+        void writeString(std::string_view string) noexcept override;
+        void writeElements(const ElementSet& elements) noexcept override;
+        // #endregion
+    private:
+        // every value of a section but the first is preceded by a space
+        void separate() noexcept;
+
+        std::ostream& saveLocation_;
+        const ElementDictionary& dictionary_;
+        bool sectionStart_ = true;
+};
+
+// parses the text encoding out of large blocks of it with from_chars, rather than token by token through the stream
+class TextMachineReader : public MachineReader {
+    public:
+        // reads loadLocation a record at a time as it is parsed
+        TextMachineReader(std::istream& loadLocation, ElementDictionary& dictionary) noexcept;
+        // parses straight from loadLocation, which the dictionary retains to intern element strings as views into it
+        TextMachineReader(std::shared_ptr<const MappedFile> loadLocation, ElementDictionary& dictionary) noexcept;
+
+        // #region MachineReader public members override
+        bool beginSet(char& type, bool& humanIncluded, std::string& name) noexcept override;
+        void endSet() noexcept override;
+        size_t readSize() noexcept override;
+        std::string_view readString() noexcept override;
+        std::vector<ElementId> readElements() noexcept override;
+        // #endregion
+
+        // whether nothing but whitespace is left to read
+        bool atEnd() noexcept;
+    private:
+        // makes at least count more bytes available to parse, returning false if the saved sets end before that
+        bool fill(size_t count) noexcept;
+        void skipSpaces() noexcept;
+
+        std::istream* loadLocation_ = nullptr;
+        std::shared_ptr<const MappedFile> mappedFile_;
+        ElementDictionary& dictionary_;
+        // the blocks read from the stream that are not parsed yet
+        std::string buffer_;
+        // what is left to parse of the buffer or the mapped file, from position_ on
+        std::string_view data_;
+        size_t position_ = 0;
+};
+
+// gathers the elements a hierarchy saves without writing anything, which the binary encoding needs before it writes any record
+class MachineElementCollector : public MachineWriter {
+    public:
+        MachineElementCollector(const ElementDictionary& dictionary) noexcept;
+
+        // #region MachineWriter public members override
+        void beginSet(char, bool, std::string_view) noexcept override {}
+        void endSet() noexcept override {}
+        void endSubsets() noexcept override {}
+        void writeSize(size_t) noexcept override {}
+        void writeString(std::string_view) noexcept override {}
+        void writeElements(const ElementSet& elements) noexcept override;
+        // #endregion
+
+        // every element written, sorted by id
+        std::vector<ElementId> elements() const noexcept;
+    private:
+        std::vector<bool> written_;
+};
+
+// records everything written to it, copying the elements, so that it can be written again later,
+// such as on another thread while the sets that wrote it keep changing
+class MachineRecording : public MachineWriter {
+    public:
+        // #region MachineWriter public members override
+        void beginSet(char type, bool humanIncluded, std::string_view name) noexcept override;
+        void endSet() noexcept override;
+        void endSubsets() noexcept override;
+        void writeSize(size_t size) noexcept override;
+        void writeString(std::string_view string) noexcept override;
+        void writeElements(const ElementSet& elements) noexcept override;
+        // #endregion
+
+        // writes everything recorded to saveLocation, in the order it was recorded
+        void replay(MachineWriter& saveLocation) const noexcept;
+    private:
+        enum class Call {
+            BEGIN_SET,
+            END_SET,
+            END_SUBSETS,
+            WRITE_SIZE,
+            WRITE_STRING,
+            WRITE_ELEMENTS
+        };
+        struct Record {
+            Call call;
+            // the size written, or the position of the string or elements written among those recorded
+            size_t value;
+            char type;
+            bool humanIncluded;
+        };
+
+        std::vector<Record> records_;
+        std::vector<std::string> strings_;
+        std::vector<ElementSet> elements_;
+};
+
+class BinaryMachineWriter : public MachineWriter {
+    public:
+        // writes the header, and the section of every element string of savedElements, which are sorted by id
+        BinaryMachineWriter(std::ostream& saveLocation, const ElementDictionary& dictionary, const std::vector<ElementId>& savedElements) noexcept;
+        ~BinaryMachineWriter() noexcept override;
+
+        // #region MachineWriter public members override
+        void beginSet(char type, bool humanIncluded, std::string_view name) noexcept override;
+        void endSet() noexcept override;
+        void endSubsets() noexcept override;
+        void writeSize(size_t size) noexcept override;
+        void writeString(std::string_view string) noexcept override;
+        void writeElements(const ElementSet& elements) noexcept override;
+        // #endregion
+    private:
+        void beginSection() noexcept;
+        // prefixes the section with its length
+        void endSection() noexcept;
+        void flush() noexcept;
+
+        std::ostream& saveLocation_;
+        // the output since it was last flushed, which always holds the whole of an unfinished section
+        std::string buffer_;
+        size_t sectionStart_ = 0;
+        // the position of each saved element in the section of element strings, indexed by its id
+        std::vector<ElementId> positions_;
+};
+
+class BinaryMachineReader : public MachineReader {
+    public:
+        // reads everything left in loadLocation, then its header and the section of element strings
+        BinaryMachineReader(std::istream& loadLocation, ElementDictionary& dictionary) noexcept;
+        // reads the header and the section of element strings straight from loadLocation, which the dictionary retains to intern them as views into it
+        BinaryMachineReader(std::shared_ptr<const MappedFile> loadLocation, ElementDictionary& dictionary) noexcept;
+
+        // #region MachineReader public members override
+        bool beginSet(char& type, bool& humanIncluded, std::string& name) noexcept override;
+        void endSet() noexcept override;
+        size_t readSize() noexcept override;
+        std::string_view readString() noexcept override;
+        std::vector<ElementId> readElements() noexcept override;
+        // #endregion
+    private:
+        void readHeader(ElementDictionary& dictionary) noexcept;
+        uint8_t readByte() noexcept;
+        // starts a section, after which nothing past its end can be read until it is ended
+        void beginSection() noexcept;
+        // checks that all of the section was read
+        void endSection() noexcept;
+
+        // what was read from a stream, or the file the data is mapped from, whichever the data is in
+        std::string loadedData_;
+        std::shared_ptr<const MappedFile> mappedFile_;
+        std::string_view data_;
+        size_t position_ = 0;
+        // the end of the current section, or of the data outside of sections
+        size_t end_ = 0;
+        // the id each element was interned as, indexed by its position in the section of element strings
+        std::vector<ElementId> ids_;
+};
\ No newline at end of file
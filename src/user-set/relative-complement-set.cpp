@@ -24,62 +24,11 @@ UserSet* RelativeComplementSet::createSet(UserSet& parent, const std::string& na
 }
 
 void RelativeComplementSet::updateElements() noexcept {
-    elements_.release();
-    complementElements_.release();
-
-    const auto* parentElements = parent_->elements();
-    const auto* setElements = derivesFrom().at(0)->elements();
+    // https://proofwiki.org/wiki/Definition:Relative_Complement
+    // RelativeComplement(A, B) = A Difference B
+    assign(applySetOperation<SetOperation::DIFFERENCE>(parent_->view(), derivesFrom().at(0)->view()));
+}
 
-    if (parentElements == nullptr && setElements != nullptr) {
-        // the only infinite relative complement set occurs when both parent set is infinite, and subset is finite
-        complementElements_ = std::make_unique<std::set<std::string>>();
-        const auto* parentComplementElements = parent_->complementElements();
-        // https://proofwiki.org/wiki/Set_Difference_as_Intersection_with_Complement
-        // A Difference B = A Intersect ~B
-        // => ~(A Difference B) = ~(A Intersect ~B)
-        // https://proofwiki.org/wiki/De_Morgan%27s_Laws_(Set_Theory)/Set_Complement/Complement_of_Union
-        // ~(A Intersect B) = ~A Union ~B
-        // => ~(A Difference B) = ~A Union B
-        // https://proofwiki.org/wiki/Definition:Relative_Complement
-        // RelativeComplement(A, B) = A Difference B
-        // => ~(RelativeComplement(A, B)) = ~A Union B
-        std::set_union(
-            parentComplementElements->begin(), parentComplementElements->end(),
-            setElements->begin(), setElements->end(),
-            std::inserter(*complementElements_, complementElements_->begin())
-        );
-    } else {
-        elements_ = std::make_unique<std::set<std::string>>();
-        if (parentElements == nullptr && setElements == nullptr) {
-            const auto* parentComplementElements = parent_->complementElements();
-            const auto* setComplementElements = derivesFrom()[0]->complementElements();
-            // https://proofwiki.org/wiki/Definition:Relative_Complement
-            // RelativeComplement(A, B) = A Difference B
-            // https://proofwiki.org/wiki/Set_Difference_of_Complements
-            // ~B Difference ~A = A Difference B
-            // => A Difference B = ~B Difference ~A
-            // => RelativeComplement(A, B) = ~B Difference ~A
-            std::set_difference(
-                setComplementElements->begin(), setComplementElements->end(),
-                parentComplementElements->begin(), parentComplementElements->end(),
-                std::inserter(*elements_, elements_->begin())
-            );
-        // parentElements and setElements must be finite at this point, therefore, sanity checks
-        } else if (parentElements == nullptr) {
-            nowide::cout << "[FATAL ERROR]: A condition where a parent has infinite elements despite passing the only infinite element case should never happen.\n";
-            exitProgram();
-        } else if (setElements == nullptr) {
-            nowide::cout << "[FATAL ERROR]: A condition where a subset of parent has infinite elements where the parent has finite should never happen.\n";
-            exitProgram();
-        // parentElements and setElements REALLY must be finite at this point
-        } else {
-            // https://proofwiki.org/wiki/Definition:Relative_Complement
-            // RelativeComplement(A, B) = A Difference B
-            std::set_difference(
-                parentElements->begin(), parentElements->end(),
-                setElements->begin(), setElements->end(),
-                std::inserter(*elements_, elements_->begin())
-            );
-        }
-    }
+bool RelativeComplementSet::derives(ElementId element) const noexcept {
+    return parent_->contains(element) && !derivesFrom().at(0)->contains(element);
 }
\ No newline at end of file
@@ -14,12 +14,17 @@
 #include "difference-set.hpp"
 #include "symmetric-difference-set.hpp"
 #include "relative-complement-set.hpp"
+#include "expression-set.hpp"
+
+#include "helpers.hpp"
+
+#include <vector>
 
 SubSet::SubSet(
     UserSet* parent,
     const std::string& name,
-    std::unique_ptr<std::set<std::string>> elements,
-    std::unique_ptr<std::set<std::string>> complementElements
+    std::unique_ptr<ElementSet> elements,
+    std::unique_ptr<ElementSet> complementElements
 ) noexcept
     : UserSet(parent, std::move(elements), std::move(complementElements)), name_(name)
 {}
@@ -28,6 +33,53 @@ std::string_view SubSet::name() const noexcept {
     return name_;
 }
 
+bool SubSet::queryImportedWords(ElementSet& words, bool internUnknown, size_t& unknown) noexcept {
+    std::string importLocation;
+    nowide::cout << "Enter a location to import newline-delimited words from\n"
+              << "\"-\" will input from STDIN, until an empty line.\n"
+              << "or \"" << UserSet::EXIT_KEYWORD << "\" to exit: ";
+    ignoreAll(nowide::cin);;
+    std::getline(nowide::cin, importLocation);
+
+    if (insensitiveSame(importLocation, UserSet::EXIT_KEYWORD)) {
+        return false;
+    }
+    nowide::ifstream importFile;
+    if (importLocation != "-") {
+        importFile.open(importLocation);
+        if (!importFile) {
+            nowide::cout << "The file '" << importLocation << "' could not be opened.\n";
+            return false;
+        }
+    }
+    std::istream& importStream = importLocation == "-" ? static_cast<std::istream&>(nowide::cin) : importFile;
+
+    // the words are streamed into a list of ids, which is sorted once to build the set rather than inserted into it one by one
+    std::vector<ElementId> wordIds;
+    std::string word;
+    while (std::getline(importStream, word)) {
+        if (!word.empty() && word.back() == '\r') {
+            word.pop_back();
+        }
+        if (word.empty()) {
+            if (&importStream == &nowide::cin) {
+                break;
+            }
+            continue;
+        }
+        ElementId id;
+        if (dictionary().find(word, id)) {
+            wordIds.push_back(id);
+        } else if (internUnknown) {
+            wordIds.push_back(dictionary().intern(word));
+        } else {
+            ++unknown;
+        }
+    }
+    words = ElementSet(std::move(wordIds));
+    return true;
+}
+
 const auto SUBSET_CREATEABLE_SUBSET_MENU = StaticMenu<void, UserSet*, UserSet&, const std::string&>({
     {std::string(1, WordSet::type_), {"WordSet", WordSet::createSet}},
     {std::string(1, FauxWordSet::type_), {"FauxWordSet", FauxWordSet::createSet}},
@@ -36,6 +88,7 @@ const auto SUBSET_CREATEABLE_SUBSET_MENU = StaticMenu<void, UserSet*, UserSet&,
     {std::string(1, DifferenceSet::type_), {"DifferenceSet", DifferenceSet::createSet}},
     {std::string(1, SymmetricDifferenceSet::type_), {"SymmetricDifferenceSet", SymmetricDifferenceSet::createSet}},
     {std::string(1, RelativeComplementSet::type_), {"RelativeComplementSet", RelativeComplementSet::createSet}},
+    {std::string(1, ExpressionSet::type_), {"ExpressionSet", ExpressionSet::createSet}},
     {std::string(UserSet::EXIT_KEYWORD), {"Exit", UserSet::EXIT_SET_MENU}}
 });
 
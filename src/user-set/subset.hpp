@@ -14,13 +14,18 @@ class SubSet : public UserSet {
         SubSet(
             UserSet* parent,
             const std::string& name,
-            std::unique_ptr<std::set<std::string>> elements = std::unique_ptr<std::set<std::string>>(),
-            std::unique_ptr<std::set<std::string>> complementElements = std::unique_ptr<std::set<std::string>>()
+            std::unique_ptr<ElementSet> elements = std::unique_ptr<ElementSet>(),
+            std::unique_ptr<ElementSet> complementElements = std::unique_ptr<ElementSet>()
         ) noexcept;
         // Must exist in all derived SubSets for creation
         // static UserSet* createSet(UserSet& parent, const std::string& name) noexcept;
 
         std::string_view name() const noexcept override;
+    protected:
+        // asks for a file, or STDIN, to read newline-delimited words from, and puts every word that was read into words,
+        // where a word that was never interned is only interned if internUnknown, and otherwise just counted in unknown
+        // returns false if nothing was read
+        bool queryImportedWords(ElementSet& words, bool internUnknown, size_t& unknown) noexcept;
     private:
         // Queries which subsets are able to be created from SubSet type UserSets
         const Menu<void, UserSet*, UserSet&, const std::string&>& createableSubsetMenu() const noexcept override;
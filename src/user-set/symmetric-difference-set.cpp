@@ -28,89 +28,9 @@ UserSet* SymmetricDifferenceSet::createSet(UserSet& parent, const std::string& n
 }
 
 void SymmetricDifferenceSet::updateElements() noexcept {
-    elements_.release();
-    complementElements_.release();
-
-    const auto* set1Elements = derivesFrom().at(0)->elements();
-    const auto* set2Elements = derivesFrom().at(1)->elements();
+    assign(applySetOperation<SetOperation::SYMMETRIC_DIFFERENCE>(derivesFrom().at(0)->view(), derivesFrom().at(1)->view()));
+}
 
-    if ((set1Elements == nullptr) != (set2Elements == nullptr)) {
-        // symmetric difference between a finite set and infinite set yields an infinite set,
-        // so if set1 is different infinity type from set2, return nullptr
-        complementElements_ = std::make_unique<std::set<std::string>>();
-        const auto* set1ComplementElements = derivesFrom().at(0)->complementElements();
-        const auto* set2ComplementElements = derivesFrom().at(1)->complementElements();
-        if (set2ComplementElements == nullptr) {
-            const auto* set2Elements = derivesFrom().at(1)->elements();
-            // https://proofwiki.org/wiki/Category:Symmetric_Difference Definition 3
-            // A SymmetricDifference B = (A Intersect ~B) Union (~A Intersect B)
-            // ~(A SymmetricDifference B) = ~((A Intersect ~B) Union (~A Intersect B))
-            // https://proofwiki.org/wiki/De_Morgan%27s_Laws_(Set_Theory)/Set_Complement/Complement_of_Union
-            // ~(A Union B) = ~A Intersect ~B
-            // => ~(A SymmetricDifference B) = ~(A Intersect ~B) Intersect ~(~A Intersect B)
-            // https://proofwiki.org/wiki/Set_Difference_as_Intersection_with_Complement
-            // A Difference B = A Intersect ~B
-            // => ~(A SymmetricDifference B) = ~(A Intersect ~B) Difference (~A Intersect B)
-            // https://proofwiki.org/wiki/De_Morgan%27s_Laws_(Set_Theory)/Set_Complement/Complement_of_Intersection
-            // ~(A Intersect B) = ~A Union ~B
-            // => ~(A SymmetricDifference B) = (~A Union B) Difference (~A Intersect B)
-            std::set<std::string> unionSet;
-            std::set<std::string> intersectSet;
-            std::set_union(
-                set1ComplementElements->begin(), set1ComplementElements->end(),
-                set2Elements->begin(), set2Elements->end(),
-                std::inserter(unionSet, unionSet.begin())
-            );
-            std::set_intersection(
-                set1ComplementElements->begin(), set1ComplementElements->end(),
-                set2Elements->begin(), set2Elements->end(),
-                std::inserter(intersectSet, intersectSet.begin())
-            );
-            std::set_difference(
-                unionSet.begin(), unionSet.end(),
-                intersectSet.begin(), intersectSet.end(),
-                std::inserter(*complementElements_, complementElements_->begin())
-            );
-        } else {
-            const auto* set1Elements = derivesFrom().at(0)->elements();
-            // same thing as above, but backwards
-            std::set<std::string> unionSet;
-            std::set<std::string> intersectSet;
-            std::set_union(
-                set2ComplementElements->begin(), set2ComplementElements->end(),
-                set1Elements->begin(), set1Elements->end(),
-                std::inserter(unionSet, unionSet.begin())
-            );
-            std::set_intersection(
-                set2ComplementElements->begin(), set2ComplementElements->end(),
-                set1Elements->begin(), set1Elements->end(),
-                std::inserter(intersectSet, intersectSet.begin())
-            );
-            std::set_difference(
-                unionSet.begin(), unionSet.end(),
-                intersectSet.begin(), intersectSet.end(),
-                std::inserter(*complementElements_, complementElements_->begin())
-            );
-        }
-    } else {
-        elements_ = std::make_unique<std::set<std::string>>();
-        if (set1Elements == nullptr && set2Elements == nullptr) {
-            const auto* set1ComplementElements = derivesFrom().at(0)->complementElements();
-            const auto* set2ComplementElements = derivesFrom().at(1)->complementElements();
-            // https://proofwiki.org/wiki/Symmetric_Difference_of_Complements
-            // ~A SymmetricDifference ~B = A SymmetricDifference B
-            std::set_symmetric_difference(
-                set1ComplementElements->begin(), set1ComplementElements->end(),
-                set2ComplementElements->begin(), set2ComplementElements->end(),
-                std::inserter(*elements_, elements_->begin())
-            );
-        } else {
-            // does exactly what it says
-            std::set_symmetric_difference(
-                set1Elements->begin(), set1Elements->end(),
-                set2Elements->begin(), set2Elements->end(),
-                std::inserter(*elements_, elements_->begin())
-            );
-        }
-    }
+bool SymmetricDifferenceSet::derives(ElementId element) const noexcept {
+    return derivesFrom().at(0)->contains(element) != derivesFrom().at(1)->contains(element);
 }
\ No newline at end of file
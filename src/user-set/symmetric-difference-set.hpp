@@ -18,5 +18,8 @@ class SymmetricDifferenceSet : public DerivativeSet {
         static constexpr char type_ = 'S';
         char type() const noexcept override { return type_; }
         void updateElements() noexcept override;
+        // #endregion
+        // #region DerivativeSet public members override
+        bool derives(ElementId element) const noexcept override;
         // #endregion 
 };
\ No newline at end of file
@@ -0,0 +1,63 @@
+/*
+    thread-pool.cpp
+
+    ThreadPool keeps a thread for every hardware thread but the one that uses it, started the first time it is used, that wait for work between uses,
+    so that recomputing or checking a hierarchy concurrently does not start and join threads every time
+    A single pool is owned by the GlobalSet, and runs one task on all of its threads at a time, which share the work out among themselves
+*/
+#include "thread-pool.hpp"
+
+ThreadPool::~ThreadPool() noexcept {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::run(const std::function<void()>& workerTask, const std::function<void()>& callingTask) noexcept {
+    bool started = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_ == 0) {
+            if (workers_.empty()) {
+                for (unsigned i = 1; i < std::thread::hardware_concurrency(); ++i) {
+                    workers_.emplace_back(&ThreadPool::work, this);
+                }
+            }
+            task_ = &workerTask;
+            ++started_;
+            running_ = workers_.size();
+            started = true;
+        }
+    }
+    changed_.notify_all();
+    callingTask();
+    if (started) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this] { return running_ == 0; });
+        task_ = nullptr;
+    }
+}
+
+void ThreadPool::work() noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    size_t finished = 0;
+    while (true) {
+        changed_.wait(lock, [this, finished] { return stopping_ || started_ != finished; });
+        if (stopping_) {
+            return;
+        }
+        finished = started_;
+        const auto& task = *task_;
+        lock.unlock();
+        task();
+        lock.lock();
+        if (--running_ == 0) {
+            changed_.notify_all();
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+/*
+    thread-pool.hpp
+
+    ThreadPool keeps a thread for every hardware thread but the one that uses it, started the first time it is used, that wait for work between uses,
+    so that recomputing or checking a hierarchy concurrently does not start and join threads every time
+    A single pool is owned by the GlobalSet, and runs one task on all of its threads at a time, which share the work out among themselves
+*/
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+    public:
+        ThreadPool() noexcept = default;
+        // stops the threads and waits for them to return from any task they are still running,
+        // which nothing inside of a task exits the program from but through exitWithoutSaving, as that does not destroy the pool
+        ~ThreadPool() noexcept;
+
+        // runs workerTask on every thread of the pool and callingTask on the calling thread, returning once all of them have returned
+        // while the pool is running another task, such as the one this is called from, only callingTask is run, which then has to do all of the work itself
+        void run(const std::function<void()>& workerTask, const std::function<void()>& callingTask) noexcept;
+    private:
+        void work() noexcept;
+
+        std::vector<std::thread> workers_;
+        std::mutex mutex_;
+        std::condition_variable changed_;
+        const std::function<void()>* task_ = nullptr;
+        // counts the tasks started, so that every thread runs each of them once
+        size_t started_ = 0;
+        // the threads that have not returned from the current task yet
+        size_t running_ = 0;
+        bool stopping_ = false;
+};
\ No newline at end of file
@@ -1,6 +1,6 @@
 /*
     union-set.hpp
-    Union set is a derivative set that holds the union of two already existing subsets of its parent
+    Union set is a derivative set that holds the union of two or more already existing subsets of its parent
 */ 
 #pragma once
 
@@ -8,7 +8,7 @@
 
 class UnionSet : public DerivativeSet {
     public:
-        UnionSet(UserSet* parent, const std::string& name, UserSet* set1, UserSet* set2) noexcept;
+        UnionSet(UserSet* parent, const std::string& name, std::vector<UserSet*> userSets) noexcept;
         UnionSet(UserSet* parent, const std::string& name) noexcept;
     
         // #region SubSet public members override 
@@ -18,5 +18,8 @@ class UnionSet : public DerivativeSet {
         static constexpr char type_ = 'U';
         char type() const noexcept override { return type_; }
         void updateElements() noexcept override;
+        // #endregion
+        // #region DerivativeSet public members override
+        bool derives(ElementId element) const noexcept override;
         // #endregion 
 };
\ No newline at end of file
@@ -15,6 +15,7 @@
 #include "difference-set.hpp"
 #include "symmetric-difference-set.hpp"
 #include "relative-complement-set.hpp"
+#include "expression-set.hpp"
 
 #include "platform.hpp"
 #include "helpers.hpp"
@@ -24,9 +25,205 @@
 #include <stack>
 #include <stdexcept>
 #include <sstream>
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace {
+    // saves to a temporary file next to location which then replaces it, so that a file that is still mapped from being loaded is never written over,
+    // unless location is not a regular file, such as a device or a pipe, which is written to directly, returning whether it was saved
+    bool saveReplacing(UserSet& set, void (UserSet::*saveMethod)(std::ostream& saveLocation), const std::filesystem::path& location, std::ios::openmode mode) noexcept {
+        std::error_code error;
+        if (std::filesystem::exists(location, error) && !std::filesystem::is_regular_file(location, error)) {
+            nowide::ofstream saveFile(denativePath(location), mode);
+            (set.*saveMethod)(saveFile);
+            return static_cast<bool>(saveFile);
+        }
+        auto temporaryLocation = location;
+        temporaryLocation += ".tmp";
+        {
+            nowide::ofstream saveFile(denativePath(temporaryLocation), mode);
+            (set.*saveMethod)(saveFile);
+        }
+        // a journal started for what is saved only applies to it once it is on the disk
+        syncFile(temporaryLocation);
+        std::filesystem::rename(temporaryLocation, location, error);
+        if (error) {
+            nowide::cout << "Failed to save to " << location << " due to '" << error.message() << "'\n";
+            return false;
+        }
+        return true;
+    }
+
+    bool isDefaultMachineLocation(const std::filesystem::path& location) noexcept {
+        std::error_code error;
+        auto canonicalLocation = std::filesystem::weakly_canonical(location, error);
+        if (error) {
+            return false;
+        }
+        return canonicalLocation == std::filesystem::weakly_canonical(UserSet::DEFAULT_MACHINE_LOCATION, error) && !error;
+    }
+
+    // writes the contents of a file that failed to load next to the default location, so that they are not lost once it is saved over
+    void backUpLoaded(std::string_view contents) noexcept {
+        std::filesystem::path backupLocation = UserSet::DEFAULT_MACHINE_LOCATION;
+        backupLocation += ".bak";
+        nowide::ofstream backupFile(denativePath(backupLocation), std::ios::out | std::ios::binary);
+        backupFile.write(contents.data(), contents.size());
+
+        nowide::cout << "Backed up loaded data to '" << backupLocation << "'\n";
+    }
+
+    // appends every set computed from set that is not yet visited to postOrder, after all of the sets that are computed from it
+    void visitDownstream(UserSet* set, std::set<const UserSet*>& visited, std::vector<UserSet*>& postOrder) noexcept {
+        if (!visited.insert(set).second) {
+            return;
+        }
+        for (const auto& subset : set->subsets()) {
+            visitDownstream(subset.second.get(), visited, postOrder);
+        }
+        for (auto* dependent : set->dependents()) {
+            visitDownstream(dependent, visited, postOrder);
+        }
+        postOrder.push_back(set);
+    }
+
+    // adds the changes of from to into, keeping each of them sorted
+    void mergeDelta(ElementDelta& into, const ElementDelta& from) noexcept {
+        into.unbounded = into.unbounded || from.unbounded;
+        std::vector<ElementId> merged;
+        std::set_union(into.added.begin(), into.added.end(), from.added.begin(), from.added.end(), std::back_inserter(merged));
+        into.added = std::move(merged);
+        merged.clear();
+        std::set_union(into.removed.begin(), into.removed.end(), from.removed.begin(), from.removed.end(), std::back_inserter(merged));
+        into.removed = std::move(merged);
+    }
+
+    // recomputes the sets downstream of a set, each once every set it is computed from is recomputed,
+    // with the sets that recompute concurrently spread over the threads of the pool and the rest recomputed on the calling thread
+    class DownstreamRecompute {
+        public:
+            explicit DownstreamRecompute(UserSet& source) noexcept {
+                auto downstream = source.downstreamSets();
+                for (auto* set : downstream) {
+                    for (const auto& subset : set->subsets()) {
+                        ++remainingInputs_[subset.second.get()];
+                    }
+                    for (auto* dependent : set->dependents()) {
+                        ++remainingInputs_[dependent];
+                    }
+                }
+                // the source is up to date already
+                remaining_ = downstream.size() - 1;
+                finished(&source);
+            }
+
+            void run(ThreadPool& threadPool) noexcept {
+                threadPool.run([this] { work(false); }, [this] { work(true); });
+            }
+        private:
+            void work(bool callingThread) noexcept {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (true) {
+                    readyChanged_.wait(lock, [this, callingThread] {
+                        return remaining_ == 0 || !concurrentReady_.empty() || (callingThread && !serialReady_.empty());
+                    });
+                    if (remaining_ == 0) {
+                        return;
+                    }
+                    auto& ready = (callingThread && !serialReady_.empty()) ? serialReady_ : concurrentReady_;
+                    auto* set = ready.back();
+                    ready.pop_back();
+
+                    lock.unlock();
+                    set->recompute();
+                    lock.lock();
+
+                    --remaining_;
+                    finished(set);
+                    readyChanged_.notify_all();
+                }
+            }
+
+            // readies every set computed from set that has nothing else left to wait on
+            void finished(UserSet* set) noexcept {
+                auto ready = [this](UserSet* next) {
+                    if (--remainingInputs_[next] == 0) {
+                        (next->recomputesConcurrently() ? concurrentReady_ : serialReady_).push_back(next);
+                    }
+                };
+                for (const auto& subset : set->subsets()) {
+                    ready(subset.second.get());
+                }
+                for (auto* dependent : set->dependents()) {
+                    ready(dependent);
+                }
+            }
+
+            std::mutex mutex_;
+            std::condition_variable readyChanged_;
+            // the number of sets each set is computed from that are not recomputed yet
+            std::map<const UserSet*, size_t> remainingInputs_;
+            std::vector<UserSet*> concurrentReady_;
+            std::vector<UserSet*> serialReady_;
+            size_t remaining_;
+    };
+
+    // whether set is ancestor or one of its nested subsets
+    bool isWithin(const UserSet* set, const UserSet* ancestor) noexcept {
+        for (; set != nullptr; set = set->parent()) {
+            if (set == ancestor) {
+                return true;
+            }
+        }
+        return false;
+    }
 
-const std::set<std::string> UserSet::NO_ELEMENTS;
-const std::filesystem::path UserSet::DEFAULT_MACHINE_LOCATION = "managed-sets.txt";
+    // the names of the sets from top down to set, which is top or one of its nested subsets
+    std::string pathFrom(const UserSet* set, const UserSet* top) noexcept {
+        std::string path(set->name());
+        for (; set != top; set = set->parent()) {
+            path.insert(0, std::string(set->parent()->name()) + " > ");
+        }
+        return path;
+    }
+
+    // the elements of each of sets that its parent lacks, with the sets checked concurrently on the threads of the pool,
+    // which is only safe once the parent of each of them is up to date
+    std::vector<ElementSet> findElementsOutsideParents(const std::vector<const UserSet*>& sets, ThreadPool& threadPool) noexcept {
+        std::vector<ElementSet> outside(sets.size());
+        std::atomic<size_t> next(0);
+        auto work = [&sets, &outside, &next] {
+            for (size_t i = next++; i < sets.size(); i = next++) {
+                outside[i] = sets[i]->elementsOutsideParent();
+            }
+        };
+        threadPool.run(work, work);
+        return outside;
+    }
+
+    const DerivativeSet* findOutsideDependent(const UserSet* set, const UserSet* root) noexcept {
+        for (const auto* dependent : set->dependents()) {
+            if (!isWithin(dependent, root)) {
+                return dependent;
+            }
+        }
+        for (const auto& subset : set->subsets()) {
+            const auto* dependent = findOutsideDependent(subset.second.get(), root);
+            if (dependent != nullptr) {
+                return dependent;
+            }
+        }
+        return nullptr;
+    }
+}
+
+const ElementSet UserSet::NO_ELEMENTS;
+const std::filesystem::path UserSet::DEFAULT_MACHINE_LOCATION = "managed-sets.bin";
+const std::filesystem::path UserSet::DEFAULT_TEXT_MACHINE_LOCATION = "managed-sets.txt";
 const std::filesystem::path UserSet::DEFAULT_HUMAN_LOCATION = "human-readable-sets.txt";
 
 UserSet* UserSet::EXIT_SET_MENU(UserSet&, const std::string&) noexcept {
@@ -34,18 +231,23 @@ UserSet* UserSet::EXIT_SET_MENU(UserSet&, const std::string&) noexcept {
 }
 
 UserSet::UserSet(
-    std::unique_ptr<std::set<std::string>> elements,
-    std::unique_ptr<std::set<std::string>> complementElements
+    ElementDictionary* dictionary,
+    ElementIndex* index,
+    EditTransaction* transaction,
+    EditJournal* journal,
+    ThreadPool* threadPool,
+    std::unique_ptr<ElementSet> elements,
+    std::unique_ptr<ElementSet> complementElements
 ) noexcept
-    : elements_(std::move(elements)), complementElements_(std::move(complementElements))
+    : dictionary_(dictionary), index_(index), transaction_(transaction), journal_(journal), threadPool_(threadPool), elements_(std::move(elements)), complementElements_(std::move(complementElements))
 {}
 
 UserSet::UserSet(
     UserSet* parent,
-    std::unique_ptr<std::set<std::string>> elements,
-    std::unique_ptr<std::set<std::string>> complementElements
+    std::unique_ptr<ElementSet> elements,
+    std::unique_ptr<ElementSet> complementElements
 ) noexcept
-    : parent_(parent), elements_(std::move(elements)), complementElements_(std::move(complementElements))
+    : parent_(parent), dictionary_(parent->dictionary_), index_(parent->index_), transaction_(parent->transaction_), journal_(parent->journal_), threadPool_(parent->threadPool_), elements_(std::move(elements)), complementElements_(std::move(complementElements))
 {}
 
 bool UserSet::preQuery() noexcept {
@@ -53,15 +255,81 @@ bool UserSet::preQuery() noexcept {
 }
 
 void UserSet::postParentLoad() noexcept(false) {
-    updateElements();
-    for (const auto& subset : subsets_) {
-        subset.second->postParentLoad();
-    }
+    // every set is downstream of the set it is loaded into, so this computes all of them
+    recompute();
+    recomputeDownstream();
+    removeElementsOutsideParents();
 }
 
 void UserSet::postSiblingsLoad() noexcept(false) {
 }
 
+void UserSet::removeElementsOutsideParents() noexcept {
+    std::vector<const UserSet*> subsets;
+    for (const auto* set : downstreamSets()) {
+        if (set != this && isWithin(set, this)) {
+            // brings the parent up to date before it is read concurrently
+            set->parent()->view();
+            subsets.push_back(set);
+        }
+    }
+    auto outside = findElementsOutsideParents(subsets, *threadPool_);
+
+    std::vector<std::pair<UserSet*, ElementSet>> violations;
+    for (size_t i = 0; i < subsets.size(); ++i) {
+        if (!outside[i].empty()) {
+            violations.emplace_back(const_cast<UserSet*>(subsets[i]), std::move(outside[i]));
+        }
+    }
+    if (violations.empty()) {
+        return;
+    }
+    // every set comes after its parent in downstreamSets, so listing them by path is also from the top down
+    std::sort(violations.begin(), violations.end(), [this](const auto& violation1, const auto& violation2) {
+        return pathFrom(violation1.first, this) < pathFrom(violation2.first, this);
+    });
+
+    nowide::cout << "The following elements were found to be unexpectedly missing from the parents of the word sets that contain them:\n";
+    for (const auto& violation : violations) {
+        nowide::cout << pathFrom(violation.first, this) << ":";
+        for (auto element : dictionary().sorted(violation.second)) {
+            nowide::cout << " '" << dictionary().element(element) << '\'';
+        }
+        nowide::cout << '\n';
+    }
+    nowide::cout << "you may either delete these elements, exit the program without saving, or these word sets can be substituted with Faux-Wordsets which allow faux non-subsetted words\n"
+              << "Enter [D] to delete the elements, [E] to exit the program without saving, or [F] to substitute the WordSets with Faux-WordSets: ";
+    std::string input;
+    do {
+        if (!(nowide::cin >> input)) {
+            // nothing is left to answer with, so this is the same as exiting
+            exitWithoutSaving();
+        }
+    } while (std::toupper(input[0]) != 'D' && std::toupper(input[0]) != 'E' && std::toupper(input[0]) != 'F');
+    if (std::toupper(input[0]) == 'E') {
+        exitWithoutSaving();
+    }
+
+    std::map<UserSet*, ElementDelta> changes;
+    for (auto& violation : violations) {
+        auto* set = violation.first;
+        if (std::toupper(input[0]) == 'D') {
+            set->removedElements(violation.second, true);
+            changes[set].removed.assign(violation.second.begin(), violation.second.end());
+            continue;
+        }
+        // only word sets have elements outside of their parent
+        journal_->record(EditJournal::Operation::BECOME_FAUX, *set);
+        auto* parent = set->parent_;
+        auto fauxWordSet = std::make_unique<FauxWordSet>(std::move(static_cast<WordSet&>(*set)));
+        auto* replacement = fauxWordSet.get();
+        parent->subsets_[std::string(replacement->name())] = std::move(fauxWordSet);
+        replacement->recompute();
+        changes[replacement].unbounded = true;
+    }
+    updateDownstreamOf(std::move(changes));
+}
+
 bool UserSet::query() noexcept {
     queryable = true;
     onQuery();
@@ -125,15 +393,20 @@ const auto USER_SET_MENU = StaticMenu<UserSet, void>({
     {"V", {"View set-specific options", &UserSet::setSpecificOptions}},
     {"H", {"Create a human-readable output of the subsets", &UserSet::saveHumanAllConnectedSubsets}},
     {"S", {"Save all connected subsets", &UserSet::saveMachineAllConnectedSubsets}},
-    {"L", {"Load all connected subsets", &UserSet::loadMachineAllConnectedSubsets}},
+    {"ST", {"Export all connected subsets as text", &UserSet::saveTextMachineAllConnectedSubsets}},
+    {"L", {"Load all connected subsets, saved or exported as text", &UserSet::loadMachineAllConnectedSubsets}},
     {"U", {"Update internal elements", &UserSet::updateInternalElements}},
     {"T", {"Toggle whether or not this subset is inclued in human readable output", &UserSet::toggleHumanInclusion}},
     {"TR", {"Toggle whether or not this subset and all of its nested children are included in human readable output", &UserSet::toggleHumanInclusionRecursively}},
     {"LS", {"List subsets", &UserSet::listSubsets}},
     {"LE", {"List elements", &UserSet::listElements}},
+    {"F", {"Find which nested subsets contain an element", &UserSet::findElement}},
     {"C", {"Create subset", &UserSet::createSubset}},
     {"D", {"Delete a subset", &UserSet::deleteSubset}},
     {"E", {"Enter a subset", &UserSet::enterSubset}},
+    {"BT", {"Begin a transaction, which defers updating the sets computed from edited sets until it is committed", &UserSet::beginTransaction}},
+    {"CT", {"Commit the transaction", &UserSet::commitTransaction}},
+    {"RT", {"Roll back the transaction", &UserSet::rollbackTransaction}},
     {"X", {"Move up one set hierarchy, or exit program if at top", &UserSet::moveUpHierarchy}},
     {std::string(UserSet::EXIT_KEYWORD), {"Exit the program", &UserSet::exitProgram}}
 });
@@ -162,7 +435,11 @@ void UserSet::exitSetSpecificOptions() noexcept {
     setSpecificQueryable = false;
 }
 
-void UserSet::saveAllConnectedSubsets(void (UserSet::*saveMethod)(std::ostream& saveLocation), const std::filesystem::path& defaultSaveLocation) noexcept {
+void UserSet::saveAllConnectedSubsets(
+    void (UserSet::*saveMethod)(std::ostream& saveLocation),
+    const std::filesystem::path& defaultSaveLocation,
+    std::ios::openmode mode
+) noexcept {
     std::string saveLocation;
     nowide::cout << "Enter a location to save to\n"
               << "\"d\" will output to default location (" << defaultSaveLocation << ", will be loaded automatically if the program is run in the same directory).\n"
@@ -184,13 +461,41 @@ void UserSet::saveAllConnectedSubsets(void (UserSet::*saveMethod)(std::ostream&
     }
     if (saveLocation == "-") {
         (globalSet->*saveMethod)(nowide::cout);
-    } else {
-        nowide::ofstream saveFileLocation(saveLocation);
-        (globalSet->*saveMethod)(saveFileLocation);
+        return;
+    }
+    auto location = std::filesystem::path(nativeString(saveLocation));
+    if (isDefaultMachineLocation(location)) {
+        if (saveMethod == &UserSet::saveMachineSubsets) {
+            globalSet->saveDefaultMachineLocation();
+            return;
+        }
+        // the journal would be replayed on top of what is saved in full in its place
+        journal_->invalidate();
+    }
+    saveReplacing(*globalSet, saveMethod, location, mode);
+}
+
+void UserSet::saveDefaultMachineLocation() noexcept {
+    if (journal_->save()) {
+        if (journal_->compactionDue()) {
+            // recorded here, right after the save, so the snapshot holds exactly what the journal saved so far,
+            // which only copies the stored elements, while encoding and writing it through to the disk is left to the compaction thread
+            MachineRecording saved;
+            saveMachineSubsets_(saved);
+            journal_->compact(std::move(saved), dictionary().snapshot());
+        }
+        return;
+    }
+    if (saveReplacing(*this, &UserSet::saveMachineSubsets, DEFAULT_MACHINE_LOCATION, std::ios::out | std::ios::binary)) {
+        journal_->restart(DEFAULT_MACHINE_LOCATION);
     }
 }
 
-void UserSet::loadAllConnectedSubsets(void (UserSet::*loadMethod)(std::istream& loadLocation), const std::filesystem::path& defaultLoadLocation) noexcept {
+void UserSet::loadAllConnectedSubsets(
+    void (UserSet::*loadMethod)(std::istream& loadLocation),
+    void (UserSet::*loadFileMethod)(const std::filesystem::path& loadLocation),
+    const std::filesystem::path& defaultLoadLocation
+) noexcept {
     std::string loadLocation;
     nowide::cout << "Enter a location to load from\n"
               << "\"d\" will input from default location (" << defaultLoadLocation << ", will be loaded automatically if the program is run in the same directory).\n"
@@ -213,8 +518,7 @@ void UserSet::loadAllConnectedSubsets(void (UserSet::*loadMethod)(std::istream&
     if (loadLocation == "-") {
         (globalSet->*loadMethod)(nowide::cin);
     } else {
-        nowide::ifstream loadFileLocation(loadLocation);
-        (globalSet->*loadMethod)(loadFileLocation);
+        (globalSet->*loadFileMethod)(nativeString(loadLocation));
     }
 }
 
@@ -244,13 +548,14 @@ void UserSet::saveHumanSubsets_(std::ostream& saveLocation, int indentation) noe
     }
     saveLocation << "Elements {";
     
-    auto elemIt = elems->begin();
-    if (elemIt != elems->end()) {
-        saveLocation << '\n' << std::string(indentation + 6, ' ') << '\'' << *elemIt << '\'';
+    auto sortedElems = dictionary().sorted(*elems);
+    auto elemIt = sortedElems.begin();
+    if (elemIt != sortedElems.end()) {
+        saveLocation << '\n' << std::string(indentation + 6, ' ') << '\'' << dictionary().element(*elemIt) << '\'';
         ++elemIt;
     }
-    for (; elemIt != elems->end(); ++elemIt) {
-        saveLocation << ",\n" << std::string(indentation + 6, ' ') << '\'' << *elemIt << '\'';
+    for (; elemIt != sortedElems.end(); ++elemIt) {
+        saveLocation << ",\n" << std::string(indentation + 6, ' ') << '\'' << dictionary().element(*elemIt) << '\'';
     }
     saveLocation << '\n' << std::string(indentation + 2, ' ') << "},\n"
                  << std::string(indentation + 2, ' ') << "Subsets {\n";
@@ -263,101 +568,171 @@ void UserSet::saveHumanSubsets_(std::ostream& saveLocation, int indentation) noe
 }
 
 void UserSet::saveMachineAllConnectedSubsets() noexcept {
-    saveAllConnectedSubsets(&UserSet::saveMachineSubsets, DEFAULT_MACHINE_LOCATION);
+    if (refusedInTransaction()) {
+        return;
+    }
+    saveAllConnectedSubsets(&UserSet::saveMachineSubsets, DEFAULT_MACHINE_LOCATION, std::ios::out | std::ios::binary);
+}
+
+void UserSet::saveTextMachineAllConnectedSubsets() noexcept {
+    if (refusedInTransaction()) {
+        return;
+    }
+    saveAllConnectedSubsets(&UserSet::saveTextMachineSubsets, DEFAULT_TEXT_MACHINE_LOCATION);
 }
 
 void UserSet::loadMachineAllConnectedSubsets() noexcept {
-    loadAllConnectedSubsets(&UserSet::loadMachineSubsets, DEFAULT_MACHINE_LOCATION);
+    if (refusedInTransaction()) {
+        return;
+    }
+    loadAllConnectedSubsets(&UserSet::loadMachineSubsets, &UserSet::loadMachineSubsets, DEFAULT_MACHINE_LOCATION);
 }
 
 void UserSet::saveMachineSubsets(std::ostream& saveLocation) noexcept {
+    // every element string is saved once, ahead of the records, so the elements saved are gathered before anything is written
+    MachineElementCollector savedElements(dictionary());
+    saveMachineSubsets_(savedElements);
+    BinaryMachineWriter writer(saveLocation, dictionary(), savedElements.elements());
+    saveMachineSubsets_(writer);
+}
+
+void UserSet::saveTextMachineSubsets(std::ostream& saveLocation) noexcept {
+    TextMachineWriter writer(saveLocation, dictionary());
+    saveMachineSubsets_(writer);
+}
+
+void UserSet::saveMachineSubsets_(MachineWriter& saveLocation) noexcept {
     onQuery();
-    saveLocation << type() << ' ' << humanIncluded << ' ' << name().size() << ' ' << name() << ' ';
+    saveLocation.beginSet(type(), humanIncluded, name());
     saveMachineSubset(saveLocation);
-    saveLocation << '\n';
+    saveLocation.endSet();
     for (const auto& subset : subsets_) {
-        subset.second->saveMachineSubsets(saveLocation);
+        subset.second->saveMachineSubsets_(saveLocation);
 
         onQuery();
     }
-    saveLocation << "0\n";
+    saveLocation.endSubsets();
 }
 
-void UserSet::loadMachineSubsets_(std::istream& loadLocation) noexcept(false) {
+void UserSet::loadMachineSubsets_(MachineReader& loadLocation) noexcept(false) {
     loadMachineSubset(loadLocation);
+    loadLocation.endSet();
     while (true) {
         onQuery();
 
         char type;
-        loadLocation >> type;
-        if (type == '0') {
-            break;
-        }
-
         bool humanIncluded_;
-        loadLocation >> humanIncluded_;
-
-        int nameSize;
-        loadLocation >> nameSize;
-
-        skipRead(loadLocation, 1);
-
         std::string name;
-        name.resize(nameSize);
-        loadLocation.read(name.data(), nameSize);
-        switch (type) {
-            case WordSet::type_:
-                subsets_[name] = std::make_unique<WordSet>(this, name);
-                break;
-            case FauxWordSet::type_:
-                subsets_[name] = std::make_unique<FauxWordSet>(this, name);
-                break;
-            case DirectorySet::type_:
-                subsets_[name] = std::make_unique<DirectorySet>(this, name);
-                break;
-            case IntersectionSet::type_:
-                subsets_[name] = std::make_unique<IntersectionSet>(this, name);
-                break;
-            case UnionSet::type_:
-                subsets_[name] = std::make_unique<UnionSet>(this, name);
-                break;
-            case DifferenceSet::type_:
-                subsets_[name] = std::make_unique<DifferenceSet>(this, name);
-                break;
-            case SymmetricDifferenceSet::type_:
-                subsets_[name] = std::make_unique<SymmetricDifferenceSet>(this, name);
-                break;
-            case RelativeComplementSet::type_:
-                subsets_[name] = std::make_unique<RelativeComplementSet>(this, name);
-                break;
-            case GlobalSet::type_:
-            default:
-                throw std::logic_error("Global or non-defined type found in load case");
-        }
-        subsets_.at(name)->humanIncluded = humanIncluded_;
-        subsets_.at(name)->loadMachineSubsets_(loadLocation);
+        if (!loadLocation.beginSet(type, humanIncluded_, name)) {
+            if (!loadLocation.error().empty()) {
+                throw std::logic_error(loadLocation.error());
+            }
+            break;
+        }
+        loadSubsetRecord(type, humanIncluded_, name, loadLocation);
+    }
+    if (!loadLocation.error().empty()) {
+        throw std::logic_error(loadLocation.error());
     }
     for (const auto& subset : subsets_) {
         subset.second->postSiblingsLoad();
     }
 }
 
-void UserSet::loadMachineSubsets(std::istream& loadLocation) noexcept {
-    char subtype;
-    loadLocation >> subtype;
+void UserSet::loadSubsetRecord(char type, bool humanIncluded, const std::string& name, MachineReader& loadLocation) noexcept(false) {
+    switch (type) {
+        case WordSet::type_:
+            subsets_[name] = std::make_unique<WordSet>(this, name);
+            break;
+        case FauxWordSet::type_:
+            subsets_[name] = std::make_unique<FauxWordSet>(this, name);
+            break;
+        case DirectorySet::type_:
+            subsets_[name] = std::make_unique<DirectorySet>(this, name);
+            break;
+        case IntersectionSet::type_:
+            subsets_[name] = std::make_unique<IntersectionSet>(this, name);
+            break;
+        case UnionSet::type_:
+            subsets_[name] = std::make_unique<UnionSet>(this, name);
+            break;
+        case DifferenceSet::type_:
+            subsets_[name] = std::make_unique<DifferenceSet>(this, name);
+            break;
+        case SymmetricDifferenceSet::type_:
+            subsets_[name] = std::make_unique<SymmetricDifferenceSet>(this, name);
+            break;
+        case RelativeComplementSet::type_:
+            subsets_[name] = std::make_unique<RelativeComplementSet>(this, name);
+            break;
+        case ExpressionSet::type_:
+            subsets_[name] = std::make_unique<ExpressionSet>(this, name);
+            break;
+        case GlobalSet::type_:
+        default:
+            throw std::logic_error("Global or non-defined type found in load case");
+    }
+    subsets_.at(name)->humanIncluded = humanIncluded;
+    subsets_.at(name)->loadMachineSubsets_(loadLocation);
+}
 
-    loadLocation >> humanIncluded;
+void UserSet::loadMachineSubsets(std::istream& loadLocation) noexcept {
+    // the journal only applies to what is saved at the default location
+    journal_->invalidate();
+    loadJournaledMachineSubsets(loadLocation, {});
+}
 
-    int subsetNameSize;
-    loadLocation >> subsetNameSize;
+void UserSet::loadJournaledMachineSubsets(std::istream& loadLocation, const std::vector<std::string>& journaled) noexcept {
+    std::unique_ptr<MachineReader> reader;
+    if (isBinaryMachineFormat(loadLocation)) {
+        reader = std::make_unique<BinaryMachineReader>(loadLocation, dictionary());
+    } else {
+        reader = std::make_unique<TextMachineReader>(loadLocation, dictionary());
+    }
+    if (!loadMachineSubsetsFrom(*reader, journaled)) {
+        loadLocation.clear();
+        loadLocation.seekg(0);
+        if (loadLocation.tellg() == 0) {
+            std::ostringstream osstr;
+            loadLocation >> osstr.rdbuf();
+            backUpLoaded(osstr.str());
+        }
+    }
+}
 
-    skipRead(loadLocation, 1);
+void UserSet::loadMachineSubsets(const std::filesystem::path& loadLocation) noexcept {
+    std::vector<std::string> journaled;
+    if (isDefaultMachineLocation(loadLocation)) {
+        journaled = journal_->load(loadLocation);
+    } else {
+        journal_->invalidate();
+    }
+    auto mappedFile = std::make_shared<const MappedFile>(loadLocation);
+    if (!mappedFile->mapped()) {
+        nowide::ifstream loadFile(denativePath(loadLocation), std::ios::in | std::ios::binary);
+        loadJournaledMachineSubsets(loadFile, journaled);
+        return;
+    }
+    std::unique_ptr<MachineReader> reader;
+    if (isBinaryMachineFormat(mappedFile->contents())) {
+        reader = std::make_unique<BinaryMachineReader>(mappedFile, dictionary());
+    } else {
+        reader = std::make_unique<TextMachineReader>(mappedFile, dictionary());
+    }
+    if (!loadMachineSubsetsFrom(*reader, journaled)) {
+        backUpLoaded(mappedFile->contents());
+    }
+}
 
+bool UserSet::loadMachineSubsetsFrom(MachineReader& reader, const std::vector<std::string>& journaled) noexcept {
+    char subtype = '\0';
     std::string subsetName;
-    subsetName.resize(subsetNameSize);
-    loadLocation.read(subsetName.data(), subsetNameSize);
+    reader.beginSet(subtype, humanIncluded, subsetName);
     bool caughtError = false;
     try {
+        if (!reader.error().empty()) {
+            throw std::logic_error(reader.error());
+        }
         if (subtype != type()) {
             throw std::logic_error("type mismatch in head set");
         }
@@ -365,8 +740,13 @@ void UserSet::loadMachineSubsets(std::istream& loadLocation) noexcept {
             throw std::logic_error("name mismatch in head set");
         }
 
+        for (const auto& subset : subsets_) {
+            subset.second->detach();
+        }
         subsets_.clear();
-        loadMachineSubsets_(loadLocation);
+        loadMachineSubsets_(reader);
+        // the changes since the sets were saved in full are made to what they store before anything is computed from it, so that it is only computed once
+        replayJournal(journaled);
         postParentLoad();
     } catch (const std::logic_error& error) {
         nowide::cout << "[IMPORTANT ERROR]\n"
@@ -388,32 +768,231 @@ void UserSet::loadMachineSubsets(std::istream& loadLocation) noexcept {
         caughtError = true;
     }
     if (caughtError) {
-        loadLocation.seekg(0);
-        if (loadLocation.tellg() == 0) {
-            std::filesystem::path backupLocation = DEFAULT_MACHINE_LOCATION;
-            backupLocation.append(".bak");
-            nowide::ofstream backupFile(denativePath(backupLocation));
-            std::ostringstream osstr;
-            loadLocation >> osstr.rdbuf();
-            std::string remainingContents = osstr.str();
+        for (const auto& subset : subsets_) {
+            subset.second->detach();
+        }
+        subsets_.clear();
+        // what is saved is not what was loaded anymore, so it has to be saved in full
+        journal_->invalidate();
+    }
+    return !caughtError;
+}
 
-            backupFile.write(remainingContents.data(), remainingContents.size());
+void UserSet::replayJournal(const std::vector<std::string>& batches) noexcept {
+    // replaying the changes is not a change of its own
+    journal_->pause();
+    try {
+        for (const auto& batch : batches) {
+            std::istringstream batchStream(batch);
+            TextMachineReader reader(batchStream, dictionary());
+            while (replayRecord(reader));
+        }
+    } catch (const std::logic_error& error) {
+        nowide::cout << "Failed to replay the journal of the changes saved since the sets were saved in full due to '" << error.what() << "', "
+                  << "so the changes after it were not made.\n";
+        // appending to a journal that cannot be replayed would lose whatever is appended, so the sets are saved in full next
+        journal_->invalidate();
+    }
+    journal_->resume();
+}
 
-            nowide::cout << "Backed up loaded data to '" << backupLocation << "'\n";
+bool UserSet::replayRecord(MachineReader& journal) noexcept(false) {
+    auto operation = static_cast<EditJournal::Operation>(journal.readSize());
+    if (!journal.error().empty()) {
+        throw std::logic_error(journal.error());
+    }
+    if (operation == EditJournal::Operation::END) {
+        return false;
+    }
+    auto* set = this;
+    for (auto depth = journal.readSize(); depth > 0; --depth) {
+        std::string name(journal.readString());
+        if (!journal.error().empty()) {
+            throw std::logic_error(journal.error());
         }
-        subsets_.clear();
+        auto subsetIt = set->subsets_.find(name);
+        if (subsetIt == set->subsets_.end()) {
+            throw std::logic_error("a change was journaled to the set '" + name + "' which does not exist");
+        }
+        set = subsetIt->second.get();
     }
+
+    switch (operation) {
+        case EditJournal::Operation::INSERT:
+        case EditJournal::Operation::ERASE:
+            set->replayEdit(dictionary().intern(journal.readString()), operation == EditJournal::Operation::INSERT);
+            break;
+        case EditJournal::Operation::CREATE: {
+            char type;
+            bool subsetHumanIncluded;
+            std::string name;
+            if (!journal.beginSet(type, subsetHumanIncluded, name)) {
+                throw std::logic_error(journal.error().empty() ? "a created set was journaled without its record" : journal.error());
+            }
+            if (set->subsets_.count(name) != 0) {
+                throw std::logic_error("the set '" + name + "' was journaled as created where one already exists");
+            }
+            set->loadSubsetRecord(type, subsetHumanIncluded, name, journal);
+            set->subsets_.at(name)->postSiblingsLoad();
+            break;
+        }
+        case EditJournal::Operation::DELETE:
+            if (set == this) {
+                throw std::logic_error("the top set was journaled as deleted");
+            }
+            set->detach();
+            set->parent_->subsets_.erase(std::string(set->name()));
+            break;
+        case EditJournal::Operation::HUMAN_INCLUSION: {
+            bool state = journal.readSize() != 0;
+            if (journal.readSize() != 0) {
+                set->toggleHumanInclusionRecursively_(state);
+            } else {
+                set->humanIncluded = state;
+            }
+            break;
+        }
+        case EditJournal::Operation::BECOME_FAUX: {
+            if (set->type() != WordSet::type_) {
+                throw std::logic_error("the set '" + std::string(set->name()) + "' was journaled as becoming a faux word set without being a word set");
+            }
+            auto* parent = set->parent_;
+            auto fauxWordSet = std::make_unique<FauxWordSet>(std::move(static_cast<WordSet&>(*set)));
+            parent->subsets_[std::string(fauxWordSet->name())] = std::move(fauxWordSet);
+            break;
+        }
+        case EditJournal::Operation::CHANGE_DIRECTORY:
+            if (set->type() != DirectorySet::type_) {
+                throw std::logic_error("the set '" + std::string(set->name()) + "' was journaled as changing directory without being a directory set");
+            }
+            set->loadMachineSubset(journal);
+            break;
+        default:
+            throw std::logic_error("a change of an unknown kind was journaled");
+    }
+    if (!journal.error().empty()) {
+        throw std::logic_error(journal.error());
+    }
+    return true;
 }
 
 void UserSet::updateInternalElements() noexcept {
-    if (parent_ != nullptr) {
-        parent_->updateInternalElements();
+    if (refusedInTransaction()) {
+        return;
+    }
+    std::vector<UserSet*> lineage;
+    for (auto* set = this; set != nullptr; set = set->parent_) {
+        lineage.push_back(set);
+    }
+    // this set is computed from its ancestors, so they are updated first, from the top down
+    for (auto it = lineage.rbegin(); it != lineage.rend(); ++it) {
+        (*it)->updateElements();
+    }
+    updateDownstream();
+}
+
+ElementDelta UserSet::applyDelta(const ElementDelta&) noexcept {
+    updateElements();
+    ElementDelta delta;
+    delta.unbounded = true;
+    return delta;
+}
+
+void UserSet::updateDownstream(ElementDelta delta) noexcept {
+    std::map<UserSet*, ElementDelta> changes;
+    changes.emplace(this, std::move(delta));
+    updateDownstreamOf(std::move(changes));
+}
+
+std::vector<UserSet*> UserSet::updateDownstreamOf(std::map<UserSet*, ElementDelta> changes) noexcept {
+    std::set<const UserSet*> visited;
+    std::vector<UserSet*> downstream;
+    for (const auto& change : changes) {
+        if (!change.second.empty()) {
+            visitDownstream(change.first, visited, downstream);
+        }
+    }
+    // a reversed post-order of every changed set together is still a topological order of all the sets computed from them
+    std::reverse(downstream.begin(), downstream.end());
+
+    // only the sets that were up to date before the changes can apply them to their elements,
+    // the rest are left to be recomputed in full, which is also the case for everything computed from them
+    std::set<const UserSet*> outdated;
+    for (auto* set : downstream) {
+        if (outdated.count(set) == 0 && set->current()) {
+            continue;
+        }
+        outdated.insert(set);
+        for (const auto& subset : set->subsets_) {
+            outdated.insert(subset.second.get());
+        }
+        outdated.insert(set->dependents_.begin(), set->dependents_.end());
+    }
+
+    // the changes that reached each set from the sets it is computed from, which all come before it in downstream
+    std::map<const UserSet*, ElementDelta> inputDeltas;
+    for (auto* set : downstream) {
+        ElementDelta delta;
+        auto inputDeltaIt = inputDeltas.find(set);
+        if (inputDeltaIt != inputDeltas.end()) {
+            inputDeltaIt->second.unbounded = inputDeltaIt->second.unbounded || outdated.count(set) != 0;
+            delta = set->applyDelta(inputDeltaIt->second);
+            inputDeltas.erase(inputDeltaIt);
+        }
+        // the changed sets are already up to date with their own changes
+        auto changeIt = changes.find(set);
+        if (changeIt != changes.end()) {
+            mergeDelta(delta, changeIt->second);
+        }
+        if (delta.empty()) {
+            continue;
+        }
+        ++set->version_;
+        for (const auto& subset : set->subsets_) {
+            mergeDelta(inputDeltas[subset.second.get()], delta);
+        }
+        for (auto* dependent : set->dependents_) {
+            mergeDelta(inputDeltas[dependent], delta);
+        }
     }
+    return downstream;
+}
+
+void UserSet::recomputeDownstream() noexcept {
+    DownstreamRecompute(*this).run(*threadPool_);
+}
+
+void UserSet::recompute() noexcept {
     updateElements();
+    ++version_;
+}
+
+bool UserSet::recomputesConcurrently() const noexcept {
+    return false;
+}
+
+void UserSet::updateDownstream() noexcept {
+    ElementDelta delta;
+    delta.unbounded = true;
+    updateDownstream(std::move(delta));
+}
+
+std::vector<UserSet*> UserSet::downstreamSets() noexcept {
+    // a reversed depth first post-order is a topological order of the sets computed from this set,
+    // as the set hierarchy together with the derivative sets is acyclic
+    std::set<const UserSet*> visited;
+    std::vector<UserSet*> downstream;
+    visitDownstream(this, visited, downstream);
+    std::reverse(downstream.begin(), downstream.end());
+    return downstream;
 }
 
 void UserSet::toggleHumanInclusion() noexcept {
     humanIncluded = !humanIncluded;
+    if (auto* record = journal_->record(EditJournal::Operation::HUMAN_INCLUSION, *this)) {
+        record->writeSize(humanIncluded);
+        record->writeSize(false);
+    }
     nowide::cout << "Human inclusion of this subset was turned " << (humanIncluded ? "on" : "off") << ".\n";
 }
 
@@ -427,6 +1006,10 @@ void UserSet::toggleHumanInclusionRecursively_(bool state) noexcept {
 void UserSet::toggleHumanInclusionRecursively() noexcept {
     humanIncluded = !humanIncluded;
     toggleHumanInclusionRecursively_(humanIncluded);
+    if (auto* record = journal_->record(EditJournal::Operation::HUMAN_INCLUSION, *this)) {
+        record->writeSize(humanIncluded);
+        record->writeSize(true);
+    }
     nowide::cout << "Human inclusion of this subset and all of its nested children was turned " << (humanIncluded ? "on" : "off") << ".\n";
 }
 
@@ -444,18 +1027,38 @@ void UserSet::listElements() noexcept {
     nowide::cout << std::string(80, '-') << '\n';
     if (elements() == nullptr) {
         nowide::cout << "This set contains every element except for:\n";
-        for (const auto& element : *complementElements()) {
-            nowide::cout << '\'' << element << "'\n";
+        for (auto element : dictionary().sorted(*complementElements())) {
+            nowide::cout << '\'' << dictionary().element(element) << "'\n";
         }
     } else {
         nowide::cout << "This set contains:\n";
-        for (const auto& element : *elements()) {
-            nowide::cout << '\'' << element << "'\n";
+        for (auto element : dictionary().sorted(*elements())) {
+            nowide::cout << '\'' << dictionary().element(element) << "'\n";
         }
     }
     nowide::cout << std::string(80, '-') << '\n';
 }
 
+void UserSet::findElement() noexcept {
+    nowide::cout << "Specify a word to find the sets of: ";
+    std::string word;
+    ignoreAll(nowide::cin);;
+    std::getline(nowide::cin, word);
+
+    std::vector<std::string> paths;
+    for (const auto* set : containingSets(std::string_view(word))) {
+        paths.push_back(pathFrom(set, this));
+    }
+    std::sort(paths.begin(), paths.end());
+
+    nowide::cout << "Containing set list\n";
+    nowide::cout << std::string(80, '-') << '\n';
+    for (const auto& path : paths) {
+        nowide::cout << path << '\n';
+    }
+    nowide::cout << std::string(80, '-') << '\n';
+}
+
 void UserSet::createSubset() noexcept {
     std::string name;
 
@@ -478,14 +1081,27 @@ void UserSet::createSubset() noexcept {
         return;
     }
     subsets_[name] = std::unique_ptr<UserSet>(subset);
+    if (auto* record = journal_->record(EditJournal::Operation::CREATE, *this)) {
+        subset->saveMachineSubsets_(*record);
+    }
 }
 
 void UserSet::deleteSubset() noexcept {
+    if (refusedInTransaction()) {
+        return;
+    }
     auto* subset = selectForSubset();
     if (subset == nullptr) {
         return;
     }
 
+    const auto* dependent = subset->outsideDependent();
+    if (dependent != nullptr) {
+        nowide::cout << "The subset '" << subset->name() << "' cannot be deleted while '" << dependent->name() << "' derives from it or its subsets, delete that set first.\n";
+        return;
+    }
+    journal_->record(EditJournal::Operation::DELETE, *subset);
+    subset->detach();
     subsets_.erase(std::string(subset->name()));
 }
 
@@ -498,46 +1114,359 @@ void UserSet::enterSubset() noexcept {
     while (subset->query());
 }
 
+void UserSet::beginTransaction() noexcept {
+    if (transaction_->open) {
+        nowide::cout << "A transaction is already open.\n";
+        return;
+    }
+    transaction_->open = true;
+    nowide::cout << "Began a transaction, the sets computed from edited sets will be updated once it is committed.\n";
+}
+
+void UserSet::commitTransaction() noexcept {
+    if (!transaction_->open) {
+        nowide::cout << "There is no open transaction to commit.\n";
+        return;
+    }
+    transaction_->open = false;
+    for (const auto* set : updateDownstreamOf(std::move(transaction_->changes))) {
+        auto outside = set->elementsOutsideParent();
+        if (!outside.empty()) {
+            nowide::cout << "The element '" << set->dictionary().element(*outside.begin()) << "' of '" << set->name() << "' is not in its parent set, "
+                      << "so the transaction was rolled back.\n";
+            undoTransaction();
+            return;
+        }
+    }
+    // the edits are only journaled once they are kept
+    for (const auto& edit : transaction_->edits) {
+        edit.set->journalEdit(edit.element, edit.inserted);
+    }
+    transaction_->edits.clear();
+    transaction_->changes.clear();
+    nowide::cout << "The transaction was committed.\n";
+}
+
+void UserSet::rollbackTransaction() noexcept {
+    if (!transaction_->open) {
+        nowide::cout << "There is no open transaction to roll back.\n";
+        return;
+    }
+    undoTransaction();
+    nowide::cout << "The transaction was rolled back.\n";
+}
+
+void UserSet::undoTransaction() noexcept {
+    transaction_->open = false;
+    std::map<UserSet*, ElementDelta> changes;
+    auto& edits = transaction_->edits;
+    // neither the edits nor undoing them are journaled
+    journal_->pause();
+    for (auto editIt = edits.rbegin(); editIt != edits.rend(); ++editIt) {
+        editIt->set->undoEdit(*editIt->elements, editIt->element, editIt->inserted);
+        // some of the sets computed from set may already be updated with the edits, if the transaction was committed
+        changes[editIt->set].unbounded = true;
+    }
+    journal_->resume();
+    edits.clear();
+    transaction_->changes.clear();
+    updateDownstreamOf(std::move(changes));
+}
+
+bool UserSet::refusedInTransaction() const noexcept {
+    if (transaction_->open) {
+        nowide::cout << "This cannot be done while a transaction is open, commit or roll it back first.\n";
+    }
+    return transaction_->open;
+}
+
 void UserSet::moveUpHierarchy() noexcept {
     queryable = false;
 }
 
 void UserSet::exitProgram() noexcept {
+    if (transaction_->open) {
+        undoTransaction();
+        nowide::cout << "The open transaction was rolled back.\n";
+    }
     nowide::cout << "Do you want to save to default location before exiting? ('n' for no, anything else assumed yes): ";
     ignoreAll(nowide::cin);;
     char c;
     nowide::cin.get(c);
     if (std::tolower(c) != 'n') {
-        nowide::ofstream defaultLocation(denativePath(UserSet::DEFAULT_MACHINE_LOCATION));
         UserSet* global = this;
         while (global->parent() != nullptr) {
             global = global->parent();
         }
-        global->saveMachineSubsets(defaultLocation);
+        global->saveDefaultMachineLocation();
     }
     exit(0);
 }
 
-const std::set<std::string>* UserSet::elements() const noexcept {
+const ElementSet* UserSet::elements() const noexcept {
+    refresh();
     return elements_.get();
 }
 
-const std::set<std::string>* UserSet::complementElements() const noexcept {
+const ElementSet* UserSet::complementElements() const noexcept {
+    refresh();
     return complementElements_.get();
 }
 
-bool UserSet::contains(const std::string& element) const noexcept {
+SetView UserSet::view() const noexcept {
+    refresh();
+    if (elements_ != nullptr) {
+        return {false, elements_.get()};
+    }
+    return {true, complementElements_.get()};
+}
+
+uint64_t UserSet::version() const noexcept {
+    refresh();
+    return version_;
+}
+
+void UserSet::refresh() const noexcept {
+}
+
+bool UserSet::current() const noexcept {
+    return true;
+}
+
+void UserSet::assign(SetValue&& value) noexcept {
+    auto stored = std::make_unique<ElementSet>(std::move(value.stored));
+    if (value.complemented) {
+        elements_.reset();
+        complementElements_ = std::move(stored);
+    } else {
+        elements_ = std::move(stored);
+        complementElements_.reset();
+    }
+}
+
+const ElementDictionary& UserSet::dictionary() const noexcept {
+    return *dictionary_;
+}
+
+ElementDictionary& UserSet::dictionary() noexcept {
+    return *dictionary_;
+}
+
+const ElementIndex& UserSet::index() const noexcept {
+    return *index_;
+}
+
+ElementIndex& UserSet::index() noexcept {
+    return *index_;
+}
+
+std::vector<const ElementSet*> UserSet::indexedElements() const noexcept {
+    return {};
+}
+
+bool UserSet::indexes(const ElementSet& elements) const noexcept {
+    auto indexed = indexedElements();
+    return std::find(indexed.begin(), indexed.end(), &elements) != indexed.end();
+}
+
+ElementSet UserSet::elementsOutsideParent() const noexcept {
+    return ElementSet();
+}
+
+bool UserSet::insertStored(ElementSet& elements, ElementId element) noexcept {
+    if (!elements.insert(element)) {
+        return false;
+    }
+    if (indexes(elements)) {
+        index_->insert(this, element);
+    }
+    if (transaction_->open) {
+        transaction_->edits.push_back({this, &elements, element, true});
+    } else {
+        journalEdit(element, true);
+    }
+    return true;
+}
+
+void UserSet::insertStored(ElementSet& elements, const ElementSet& inserted) noexcept {
+    auto gained = ElementSet::difference(inserted, elements);
+    if (gained.empty()) {
+        return;
+    }
+    if (indexes(elements)) {
+        index_->insert(this, gained);
+    }
+    for (auto element : gained) {
+        if (transaction_->open) {
+            transaction_->edits.push_back({this, &elements, element, true});
+        } else {
+            journalEdit(element, true);
+        }
+    }
+    // a single merge of both sorted sets, rather than inserting each element on its own
+    elements = ElementSet::unite(elements, gained);
+}
+
+void UserSet::eraseStored(ElementSet& elements, const ElementSet& erased) noexcept {
+    auto lost = ElementSet::intersect(elements, erased);
+    if (lost.empty()) {
+        return;
+    }
+    if (indexes(elements)) {
+        index_->erase(this, lost);
+    }
+    for (auto element : lost) {
+        if (transaction_->open) {
+            transaction_->edits.push_back({this, &elements, element, false});
+        } else {
+            journalEdit(element, false);
+        }
+    }
+    elements = ElementSet::difference(elements, lost);
+}
+
+void UserSet::undoEdit(ElementSet& elements, ElementId element, bool inserted) noexcept {
+    // the transaction is no longer open, so this is not recorded as an edit of its own
+    if (inserted) {
+        eraseStored(elements, ElementSet(std::vector<ElementId>{element}));
+    } else {
+        insertStored(elements, element);
+    }
+}
+
+void UserSet::replayEdit(ElementId, bool) noexcept {
+    // only the sets that store their elements themselves journal edits to them
+}
+
+void UserSet::journalEdit(ElementId element, bool inserted) noexcept {
+    if (auto* record = journal_->record(inserted ? EditJournal::Operation::INSERT : EditJournal::Operation::ERASE, *this)) {
+        record->writeString(dictionary().element(element));
+    }
+}
+
+void UserSet::changed(ElementDelta delta) noexcept {
+    if (transaction_->open) {
+        mergeDelta(transaction_->changes[this], delta);
+        return;
+    }
+    updateDownstream(std::move(delta));
+}
+
+bool UserSet::contains(ElementId element) const noexcept {
+    refresh();
     if (elements_.get() != nullptr) {
-        return elements_->count(element) == 1;
+        return elements_->contains(element);
     } else {
-        return complementElements_->count(element) == 0;
+        return !complementElements_->contains(element);
+    }
+}
+
+bool UserSet::contains(const std::string& element) const noexcept {
+    ElementId id;
+    if (!dictionary().find(element, id)) {
+        // an element that was never interned cannot be in any set's elements or complement elements
+        return elements() == nullptr;
     }
+    return contains(id);
+}
+
+void UserSet::removedElement(ElementId element, bool expected) noexcept {
+    removedElements(ElementSet(std::vector<ElementId>{element}), expected);
 }
 
-void UserSet::removedElement(const std::string& element, bool expected) noexcept {
+void UserSet::removedElements(const ElementSet& elements, bool expected) noexcept {
+    removedFromSubsets(elements, expected);
+}
+
+void UserSet::removedFromSubsets(const ElementSet& elements, bool expected) noexcept {
+    // a subset that stores none of elements, and has no nested subset that does, has nothing to remove
+    std::set<const UserSet*> storing;
+    if (index_->enabled()) {
+        storing = index_->subsetsStoring(*this, elements);
+    }
     for (const auto& subset : subsets_) {
-        subset.second->removedElement(element, expected);
+        if (index_->enabled() && storing.count(subset.second.get()) == 0) {
+            continue;
+        }
+        subset.second->removedElements(elements, expected);
+    }
+}
+
+std::vector<const UserSet*> UserSet::containingSets(ElementId element) const noexcept {
+    std::vector<const UserSet*> containing;
+    if (!index_->enabled()) {
+        std::vector<const UserSet*> unvisited{this};
+        while (!unvisited.empty()) {
+            const auto* set = unvisited.back();
+            unvisited.pop_back();
+            if (set->contains(element)) {
+                containing.push_back(set);
+            }
+            for (const auto& subset : set->subsets_) {
+                unvisited.push_back(subset.second.get());
+            }
+        }
+        return containing;
+    }
+
+    // the sets already known to contain element or not
+    std::set<const UserSet*> checked;
+    auto check = [&checked, &containing, element](const UserSet* set) {
+        if (!checked.insert(set).second) {
+            return false;
+        }
+        if (set->contains(element)) {
+            containing.push_back(set);
+        }
+        return true;
+    };
+    // every set that stores element, and the sets it is nested in, as a stored element is not always one of the elements
+    for (const auto* set : index_->sets(element)) {
+        if (!isWithin(set, this)) {
+            continue;
+        }
+        for (; set != parent_ && check(set); set = set->parent());
+    }
+    // the sets that store no elements compute them, and every set is within its parent except for the top set,
+    // so they can only contain element when the top set or the set they are nested in does
+    check(this);
+    std::vector<const UserSet*> unexpanded{this};
+    unexpanded.insert(unexpanded.end(), containing.begin(), containing.end());
+    while (!unexpanded.empty()) {
+        const auto* set = unexpanded.back();
+        unexpanded.pop_back();
+        for (const auto& subset : set->subsets_) {
+            const auto* computed = subset.second.get();
+            if (computed->indexedElements().empty() && checked.insert(computed).second && computed->contains(element)) {
+                containing.push_back(computed);
+                unexpanded.push_back(computed);
+            }
+        }
+    }
+    return containing;
+}
+
+std::vector<const UserSet*> UserSet::containingSets(std::string_view element) const noexcept {
+    ElementId id;
+    if (dictionary().find(element, id)) {
+        return containingSets(id);
+    }
+    // an element that was never interned is in exactly the sets with an infinite set of elements,
+    // and a set within a parent with a finite set of elements has a finite set of elements too
+    std::vector<const UserSet*> containing;
+    std::vector<const UserSet*> unvisited{this};
+    while (!unvisited.empty()) {
+        const auto* set = unvisited.back();
+        unvisited.pop_back();
+        if (set->elements() != nullptr) {
+            continue;
+        }
+        containing.push_back(set);
+        for (const auto& subset : set->subsets_) {
+            unvisited.push_back(subset.second.get());
+        }
     }
+    return containing;
 }
 
 const UserSet* UserSet::parent() const noexcept {
@@ -552,12 +1481,60 @@ const std::map<std::string, std::unique_ptr<UserSet>>& UserSet::subsets() const
     return subsets_;
 }
 
+const std::vector<DerivativeSet*>& UserSet::dependents() const noexcept {
+    return dependents_;
+}
+
+void UserSet::addDependent(DerivativeSet* dependent) noexcept {
+    if (std::find(dependents_.begin(), dependents_.end(), dependent) == dependents_.end()) {
+        dependents_.push_back(dependent);
+    }
+}
+
+void UserSet::removeDependent(DerivativeSet* dependent) noexcept {
+    dependents_.erase(std::remove(dependents_.begin(), dependents_.end(), dependent), dependents_.end());
+}
+
+const DerivativeSet* UserSet::outsideDependent() const noexcept {
+    return findOutsideDependent(this, this);
+}
+
+void UserSet::detach() noexcept {
+    for (const auto* elements : indexedElements()) {
+        index_->erase(this, *elements);
+    }
+    for (const auto& subset : subsets_) {
+        subset.second->detach();
+    }
+}
+
+void UserSet::takeOverConnections(UserSet& replaced) noexcept {
+    subsets_ = std::move(replaced.subsets_);
+    for (const auto& subset : subsets_) {
+        subset.second->parent_ = this;
+    }
+    dependents_ = std::move(replaced.dependents_);
+    for (auto* dependent : dependents_) {
+        dependent->replaceOperand(&replaced, this);
+    }
+}
+
 void UserSet::onQuery() noexcept {
     if (onQueryRemove != nullptr) {
+        // a set removed to add another in its place is journaled as becoming it where it does,
+        // and already handed its elements, their postings and its subsets over to the set replacing it, so there is nothing left of it to detach
+        if (!onQueryAdd) {
+            journal_->record(EditJournal::Operation::DELETE, *onQueryRemove);
+            onQueryRemove->detach();
+        }
         subsets_.erase(std::string(onQueryRemove->name()));
         onQueryRemove = nullptr;
     }
     if (onQueryAdd) {
+        auto* added = onQueryAdd.get();
         subsets_.insert({std::string(onQueryAdd->name()), std::move(onQueryAdd)});
+        // the set was not yet among the subsets when this set last changed, so it may be computed from elements this set no longer has
+        added->recompute();
+        added->updateDownstream();
     }
 }
\ No newline at end of file
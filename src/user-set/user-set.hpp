@@ -7,23 +7,67 @@
 #pragma once
 
 #include "menu.hpp"
+#include "element-set.hpp"
+#include "set-algebra.hpp"
+#include "element-dictionary.hpp"
+#include "element-index.hpp"
+#include "machine-format.hpp"
+#include "edit-journal.hpp"
+#include "thread-pool.hpp"
+
 #include <string>
 #include <set>
 #include <filesystem>
 #include <memory>
+#include <vector>
+#include <map>
 
 #include <nowide/fstream.hpp>
 
+class UserSet;
+class DerivativeSet;
+
+// the elements whose membership of a set may have changed, each sorted by id, which is all the sets computed from it need to update incrementally
+struct ElementDelta {
+    std::vector<ElementId> added;
+    std::vector<ElementId> removed;
+    // whether the changes are not known, so every set computed from the set has to be recomputed in full
+    bool unbounded = false;
+
+    bool empty() const noexcept { return !unbounded && added.empty() && removed.empty(); }
+};
+
+// the edits made to the stored elements of a set hierarchy while a transaction is open, so that they can be rolled back,
+// and how each set they were made to changed, so that the sets computed from them are only updated once it is committed
+struct EditTransaction {
+    struct Edit {
+        UserSet* set;
+        // the elements of set the edit was made to
+        ElementSet* elements;
+        ElementId element;
+        bool inserted;
+    };
+
+    bool open = false;
+    std::vector<Edit> edits;
+    std::map<UserSet*, ElementDelta> changes;
+};
+
 class UserSet {
     public:
         UserSet(
-            std::unique_ptr<std::set<std::string>> elements = std::unique_ptr<std::set<std::string>>(),
-            std::unique_ptr<std::set<std::string>> complementElements = std::unique_ptr<std::set<std::string>>()
+            ElementDictionary* dictionary,
+            ElementIndex* index,
+            EditTransaction* transaction,
+            EditJournal* journal,
+            ThreadPool* threadPool,
+            std::unique_ptr<ElementSet> elements = std::unique_ptr<ElementSet>(),
+            std::unique_ptr<ElementSet> complementElements = std::unique_ptr<ElementSet>()
         ) noexcept;
         UserSet(
             UserSet* parent,
-            std::unique_ptr<std::set<std::string>> elements = std::unique_ptr<std::set<std::string>>(),
-            std::unique_ptr<std::set<std::string>> complementElements = std::unique_ptr<std::set<std::string>>()
+            std::unique_ptr<ElementSet> elements = std::unique_ptr<ElementSet>(),
+            std::unique_ptr<ElementSet> complementElements = std::unique_ptr<ElementSet>()
         ) noexcept;
         virtual ~UserSet() noexcept = default;
 
@@ -41,36 +85,91 @@ class UserSet {
         void exitSetSpecificOptions() noexcept;
         void saveHumanAllConnectedSubsets() noexcept;
         void saveMachineAllConnectedSubsets() noexcept;
+        void saveTextMachineAllConnectedSubsets() noexcept;
         void loadMachineAllConnectedSubsets() noexcept;
         void toggleHumanInclusion() noexcept;
         void toggleHumanInclusionRecursively() noexcept;
         void toggleHumanInclusionRecursively_(bool state) noexcept;
         void listSubsets() noexcept;
         void listElements() noexcept;
+        void findElement() noexcept;
         void createSubset() noexcept;
         void deleteSubset() noexcept;
         void enterSubset() noexcept;
         void moveUpHierarchy() noexcept;
         void exitProgram() noexcept;
+        void beginTransaction() noexcept;
+        void commitTransaction() noexcept;
+        void rollbackTransaction() noexcept;
 
-        virtual void saveMachineSubset(std::ostream& saveLocation) noexcept = 0;
+        virtual void saveMachineSubset(MachineWriter& saveLocation) noexcept = 0;
+        // saves in the binary encoding of the machine format
         void saveMachineSubsets(std::ostream& saveLocation) noexcept;
+        // saves in the text encoding of the machine format, for exporting to anything that reads it
+        void saveTextMachineSubsets(std::ostream& saveLocation) noexcept;
         void saveHumanSubsets(std::ostream& saveLocation) noexcept;
-        virtual void loadMachineSubset(std::istream& loadLocation) noexcept = 0;
+        virtual void loadMachineSubset(MachineReader& loadLocation) noexcept = 0;
+        // loads either encoding of the machine format, whichever loadLocation is in
         void loadMachineSubsets(std::istream& loadLocation) noexcept;
+        // the same as loading from a stream, except that the file is mapped into memory,
+        // which the element dictionary keeps mapped, rather than copying every element string out of it,
+        // and that the changes journaled since the sets were saved in full are replayed if it is the default location
+        void loadMachineSubsets(const std::filesystem::path& loadLocation) noexcept;
 
         virtual char type() const noexcept = 0;
 
+        bool contains(ElementId element) const noexcept;
         bool contains(const std::string& element) const noexcept;
-        virtual void removedElement(const std::string& element, bool expected) noexcept;
+        void removedElement(ElementId element, bool expected) noexcept;
+        // removes all of elements from this set and its nested subsets, visiting each set once for the whole batch,
+        // where expected is false when the elements vanished from under the sets rather than being removed on purpose
+        virtual void removedElements(const ElementSet& elements, bool expected) noexcept;
+        // this set and every nested subset that contains element, found through the element index when it is enabled
+        std::vector<const UserSet*> containingSets(ElementId element) const noexcept;
+        // the same, for an element that does not have to be interned, which it is not by looking for it
+        std::vector<const UserSet*> containingSets(std::string_view element) const noexcept;
         void updateInternalElements() noexcept;
         virtual void updateElements() noexcept = 0;
-        const std::set<std::string>* elements() const noexcept;
-        const std::set<std::string>* complementElements() const noexcept;
+        // updates the elements from the sets they are computed from, given only that their elements changed by inputDelta, and returns how this set changed
+        // by default this falls back to recomputing every element with updateElements
+        virtual ElementDelta applyDelta(const ElementDelta& inputDelta) noexcept;
+        // recomputes every set whose elements are computed from this set, directly or indirectly, after this set changed by delta
+        // each of them is only updated by the changes that reach it, rather than recomputed, unless some change is unbounded
+        void updateDownstream(ElementDelta delta) noexcept;
+        void updateDownstream() noexcept;
+        // updates every set computed from any of the sets changes has a delta for at once, where each of them may also be computed from the others,
+        // and returns the sets that were updated, including those of changes, ordered so that every set comes after all of the sets it is computed from
+        static std::vector<UserSet*> updateDownstreamOf(std::map<UserSet*, ElementDelta> changes) noexcept;
+        // recomputes every set whose elements are computed from this set in full, after this set changed arbitrarily,
+        // where sets that do not depend on eachother are recomputed concurrently on a pool of threads sized to the machine
+        void recomputeDownstream() noexcept;
+        // recomputes the elements in full from the sets they are computed from
+        virtual void recompute() noexcept;
+        // whether recompute only changes this set, so that it can run concurrently with recomputing any set this set is not computed from
+        virtual bool recomputesConcurrently() const noexcept;
+        // this set followed by every set whose elements are computed from it, directly or indirectly,
+        // ordered so that every set comes after all of the sets it is computed from
+        std::vector<UserSet*> downstreamSets() noexcept;
+        const ElementSet* elements() const noexcept;
+        const ElementSet* complementElements() const noexcept;
+        SetView view() const noexcept;
+        // increases whenever the elements of this set change
+        uint64_t version() const noexcept;
+
+        const ElementDictionary& dictionary() const noexcept;
+        ElementDictionary& dictionary() noexcept;
+        const ElementIndex& index() const noexcept;
+        ElementIndex& index() noexcept;
+        // the sets of elements this set stores itself, rather than computes from other sets, which the element index tracks
+        virtual std::vector<const ElementSet*> indexedElements() const noexcept;
+        // the elements of this set that its parent lacks, which a committed transaction must leave none of
+        virtual ElementSet elementsOutsideParent() const noexcept;
 
         constexpr static std::string_view EXIT_KEYWORD = "EXIT";
-        const static std::set<std::string> NO_ELEMENTS;
+        const static ElementSet NO_ELEMENTS;
         const static std::filesystem::path DEFAULT_MACHINE_LOCATION;
+        // where the sets were saved before they were saved in the binary encoding, which is loaded if nothing is saved at DEFAULT_MACHINE_LOCATION
+        const static std::filesystem::path DEFAULT_TEXT_MACHINE_LOCATION;
         const static std::filesystem::path DEFAULT_HUMAN_LOCATION;
 
         static UserSet* EXIT_SET_MENU(UserSet&, const std::string&) noexcept;
@@ -79,6 +178,16 @@ class UserSet {
         UserSet* parent() noexcept;
         const std::map<std::string, std::unique_ptr<UserSet>>& subsets() const noexcept;
 
+        // the derivative sets that derive from this set
+        const std::vector<DerivativeSet*>& dependents() const noexcept;
+        void addDependent(DerivativeSet* dependent) noexcept;
+        void removeDependent(DerivativeSet* dependent) noexcept;
+        // a set outside of this set and its nested subsets that derives from any of them, which would be left without a set to derive from if this set was deleted
+        const DerivativeSet* outsideDependent() const noexcept;
+        // unregisters every set within this set and its nested subsets from the element index,
+        // and every derivative set among them from the sets they derive from, so it can be deleted
+        virtual void detach() noexcept;
+
         UserSet* onQueryRemove = nullptr;
         std::unique_ptr<UserSet> onQueryAdd;
         UserSet* onQueryEnter = nullptr;
@@ -86,23 +195,87 @@ class UserSet {
     protected:
         bool queryable = false;
         bool setSpecificQueryable = false;
-        UserSet* parent_;
+        UserSet* parent_ = nullptr;
+        ElementDictionary* dictionary_;
+        ElementIndex* index_;
+        EditTransaction* transaction_;
+        EditJournal* journal_;
+        ThreadPool* threadPool_;
         std::map<std::string, std::unique_ptr<UserSet>> subsets_;
-        std::unique_ptr<std::set<std::string>> elements_;
-        std::unique_ptr<std::set<std::string>> complementElements_;
+        std::unique_ptr<ElementSet> elements_;
+        std::unique_ptr<ElementSet> complementElements_;
+
+        // replaces elements_ or complementElements_, whichever value says it is, with the elements value stores
+        void assign(SetValue&& value) noexcept;
+        // insert into or erase from elements, which this set stores itself, keeping the element index up to date and recording the edits in an open transaction
+        bool insertStored(ElementSet& elements, ElementId element) noexcept;
+        void insertStored(ElementSet& elements, const ElementSet& inserted) noexcept;
+        void eraseStored(ElementSet& elements, const ElementSet& erased) noexcept;
+        // reverts inserting element into or erasing it from elements, which this set stores itself, when a transaction is rolled back
+        virtual void undoEdit(ElementSet& elements, ElementId element, bool inserted) noexcept;
+        // inserts element into or erases it from the elements this set stores itself, as journaled, where nothing is computed from them yet
+        virtual void replayEdit(ElementId element, bool inserted) noexcept;
+        // updates every set computed from this set after it changed by delta, or once the open transaction is committed if there is one
+        void changed(ElementDelta delta) noexcept;
+        // whether a transaction is open, telling the user that it has to be committed or rolled back first if it is
+        bool refusedInTransaction() const noexcept;
+        // passes removedElements on to the subsets, skipping those that store none of elements when the element index is enabled
+        void removedFromSubsets(const ElementSet& elements, bool expected) noexcept;
+        // moves the subsets and dependents of a set this set is replacing over to this set
+        void takeOverConnections(UserSet& replaced) noexcept;
+        // brings the elements up to date, for sets that only compute them once they are read after the sets they are computed from changed
+        virtual void refresh() const noexcept;
+        // whether the elements are up to date with the sets they are computed from, without bringing anything up to date
+        virtual bool current() const noexcept;
+
+        uint64_t version_ = 0;
 
     private:
         const Menu<UserSet, void>& menu() const noexcept;
         virtual const Menu<void, UserSet*, UserSet&, const std::string&>& createableSubsetMenu() const noexcept = 0;
         virtual const Menu<UserSet, void>& setSpecificMenu() const noexcept;
 
-        void saveAllConnectedSubsets(void (UserSet::*saveMethod)(std::ostream& saveLocation), const std::filesystem::path& defaultSaveLocation) noexcept;
-        void loadAllConnectedSubsets(void (UserSet::*loadMethod)(std::istream& loadLocation), const std::filesystem::path& defaultLoadLocation) noexcept;
+        void saveAllConnectedSubsets(
+            void (UserSet::*saveMethod)(std::ostream& saveLocation),
+            const std::filesystem::path& defaultSaveLocation,
+            std::ios::openmode mode = std::ios::out
+        ) noexcept;
+        void loadAllConnectedSubsets(
+            void (UserSet::*loadMethod)(std::istream& loadLocation),
+            void (UserSet::*loadFileMethod)(const std::filesystem::path& loadLocation),
+            const std::filesystem::path& defaultLoadLocation
+        ) noexcept;
+        // saves to the default location, only appending what changed since it was last saved to the journal next to it if it can,
+        // and compacting the journal into a full save in the background once it has grown large
+        void saveDefaultMachineLocation() noexcept;
         void saveSubsets(void (UserSet::*saveMethod)(std::ostream& saveLocation), nowide::ofstream& saveLocation) const noexcept;
         void loadSubsets(void (UserSet::*loadMethod)(std::istream& loadLocation), nowide::ifstream& loadLocation) noexcept;
 
         void saveHumanSubsets_(std::ostream& saveLocation, int indentation) noexcept;
-        void loadMachineSubsets_(std::istream& loadLocation) noexcept(false);
+        void saveMachineSubsets_(MachineWriter& saveLocation) noexcept;
+        void loadMachineSubsets_(MachineReader& loadLocation) noexcept(false);
+        // loads the subset that the record begun with type, humanIncluded and name is of
+        void loadSubsetRecord(char type, bool humanIncluded, const std::string& name, MachineReader& loadLocation) noexcept(false);
+        void loadJournaledMachineSubsets(std::istream& loadLocation, const std::vector<std::string>& journaled) noexcept;
+        // replaces the subsets with those loaded from reader, with each batch of journaled changes replayed on top of them,
+        // returning whether they could be, where they are left empty otherwise
+        bool loadMachineSubsetsFrom(MachineReader& reader, const std::vector<std::string>& journaled) noexcept;
+        // replays every record of each batch onto the loaded sets, stopping at the first that cannot be
+        void replayJournal(const std::vector<std::string>& batches) noexcept;
+        // replays the next record of journal, returning false instead at the end of its batch
+        bool replayRecord(MachineReader& journal) noexcept(false);
+        // records element being inserted into or erased from the elements of this set in the journal
+        void journalEdit(ElementId element, bool inserted) noexcept;
 
         void onQuery() noexcept;
+        // whether elements is one of the sets of elements the element index tracks for this set
+        bool indexes(const ElementSet& elements) const noexcept;
+        // finds every element of a nested subset that its parent lacks, and lets the user choose how to handle all of them at once
+        void removeElementsOutsideParents() noexcept;
+        // undoes every edit of the transaction and updates every set computed from the sets they were made to
+        void undoTransaction() noexcept;
+
+        std::vector<DerivativeSet*> dependents_;
+
+        friend class DerivativeSet;
 };
\ No newline at end of file
@@ -13,7 +13,7 @@
 #include <iostream>
 
 WordSet::WordSet(UserSet* parent, const std::string& name) noexcept
-    : SubSet(parent, name, std::make_unique<std::set<std::string>>())
+    : SubSet(parent, name, std::make_unique<ElementSet>())
 {}
 
 UserSet* WordSet::createSet(UserSet& parent, const std::string& name) noexcept {
@@ -25,6 +25,7 @@ const auto WORD_SET_MENU = ReinterpretMenu<WordSet, UserSet, void>({
     {"AX", {"Add a word from the parent set", &WordSet::addParentWord}},
     {"R", {"Remove a word", &WordSet::removeWord}},
     {"RX", {"Remove a word by number in this set", &WordSet::removeContainedWord}},
+    {"I", {"Import words from a file", &WordSet::importWords}},
     {"X", {"Exit set-specific options", &WordSet::exitSetSpecificOptions}},
     {std::string(UserSet::EXIT_KEYWORD), {"Exit the program", &WordSet::exitProgram}}
 });
@@ -43,7 +44,7 @@ void WordSet::addWord() noexcept {
         nowide::cout << "That word is not in the parent set, and would make this not be a subset, and was therefore not inserted\n";
         return;
     }
-    auto inserted = addElement(word);
+    auto inserted = addElement(dictionary().intern(word));
     if (!inserted) {
         nowide::cout << "That word was already in the set and was therefore not inserted\n";
     }
@@ -54,13 +55,14 @@ void WordSet::addParentWord() noexcept {
         nowide::cout << "The parent has an infinite set of elements and cannot be specified from\n";
         return;
     }
+    auto parentElements = dictionary().sorted(*parent()->elements());
     int count = 0;
-    for (const auto& element : *parent()->elements()) {
+    for (auto element : parentElements) {
         if (contains(element)) {
             continue;
         }
         ++count;
-        nowide::cout << count << ". '" << element << "'\n";
+        nowide::cout << count << ". '" << dictionary().element(element) << "'\n";
     }
 
     int selection = 0;
@@ -71,7 +73,7 @@ void WordSet::addParentWord() noexcept {
     }
     
     count = 0;
-    for (const auto& element : *parent()->elements()) {
+    for (auto element : parentElements) {
         if (contains(element)) {
             continue;
         }
@@ -91,7 +93,13 @@ void WordSet::removeWord() noexcept {
     ignoreAll(nowide::cin);;
     std::getline(nowide::cin, word);
 
-    removedElement(word, true);
+    ElementId element;
+    if (!dictionary().find(word, element) || !elements_->contains(element)) {
+        nowide::cout << "That word is not in the set and was therefore not removed\n";
+        return;
+    }
+    eraseWords(ElementSet(std::vector<ElementId>{element}));
+    changed({{}, {element}});
 }
 
 void WordSet::removeContainedWord() noexcept {
@@ -100,10 +108,11 @@ void WordSet::removeContainedWord() noexcept {
         return;
     }
 
+    auto sortedElements = dictionary().sorted(*elements_);
     int count = 0;
-    for (const auto& element : *elements_) {
+    for (auto element : sortedElements) {
         ++count;
-        nowide::cout << count << ". '" << element << "'\n";
+        nowide::cout << count << ". '" << dictionary().element(element) << "'\n";
     }
 
     int selection = 0;
@@ -114,10 +123,11 @@ void WordSet::removeContainedWord() noexcept {
     }
 
     count = 0;
-    for (const auto& element : *elements_) {
+    for (auto element : sortedElements) {
         ++count;
         if (count == selection) {
-            removedElement(element, true);
+            eraseWords(ElementSet(std::vector<ElementId>{element}));
+            changed({{}, {element}});
             return;
         }
     }
@@ -125,64 +135,110 @@ void WordSet::removeContainedWord() noexcept {
     exitProgram();
 }
 
-void WordSet::saveMachineSubset(std::ostream& saveLocation) noexcept {
-    saveLocation << elements()->size();
-    for (const auto& element : *elements()) {
-        saveLocation << ' ' << element.size() << ' ' << element;
+void WordSet::importWords() noexcept {
+    ElementSet words;
+    size_t unknownWords = 0;
+    // a word that was never interned is in no finite set, so it only has to be interned when the parent is infinite
+    if (!queryImportedWords(words, parent()->elements() == nullptr, unknownWords)) {
+        return;
     }
+    // every word is checked against the parent in a single merge of both sets
+    auto parentWords = applySetOperation<SetOperation::INTERSECT>(SetView{false, &words}, parent()->view()).stored;
+    auto addedWords = ElementSet::difference(parentWords, *elements_);
+    insertStored(*elements_, addedWords);
+    changed({std::vector<ElementId>(addedWords.begin(), addedWords.end()), {}});
+
+    nowide::cout << "Imported " << addedWords.size() << " words, "
+              << parentWords.size() - addedWords.size() << " were already in the set, and "
+              << words.size() - parentWords.size() + unknownWords << " are not in the parent set and were therefore not inserted\n";
 }
 
-void WordSet::loadMachineSubset(std::istream& loadLocation) noexcept {
-    size_t elementCount;
-    loadLocation >> elementCount;
-    for (; elementCount > 0; --elementCount) {
-        size_t elementSize;
-        loadLocation >> elementSize;
-        // pre-creates a string of elementSize to read into
-        std::string element;
-        element.resize(elementSize);
-        // skips over the space after size
-        skipRead(loadLocation, 1);
-        // reads all of the text into the element
-        loadLocation.read(element.data(), elementSize);
-        elements_->emplace(std::move(element));
-    }
+void WordSet::saveMachineSubset(MachineWriter& saveLocation) noexcept {
+    saveLocation.writeElements(*elements());
 }
 
-void WordSet::postParentLoad() noexcept(false) {
-    for (const auto& element : *elements_) {
-        if (becomingFaux != nullptr) {
-            break;
-        }
+void WordSet::loadMachineSubset(MachineReader& loadLocation) noexcept {
+    *elements_ = ElementSet(loadLocation.readElements());
+    index_->insert(this, *elements_);
+}
 
-        // if parent doesn't contain the element then issue a warning
-        if (!parent()->contains(element)) {
-            handleUnexpectedWordRemoval(element);
-            continue;
-        }
+void WordSet::updateElements() noexcept {
+}
+
+ElementDelta WordSet::applyDelta(const ElementDelta& inputDelta) noexcept {
+    // the faux word set replacing this set took over its elements, and is updated on its own once it is among the subsets
+    if (becomingFaux != nullptr) {
+        return {};
     }
+    // elements the parent gains are never added, so this set only loses the elements the parent lost that it still has,
+    // which a parent computed from other sets never passes on through removedElements,
+    // or every element the parent no longer has when what the parent lost is not known
+    ElementSet lostElements;
+    if (inputDelta.unbounded) {
+        lostElements = elementsOutsideParent();
+    } else {
+        lostElements = ElementSet::intersect(*elements_, ElementSet(inputDelta.removed));
+    }
+    eraseWords(lostElements);
+
+    auto removed = ElementSet::unite(unreportedRemovals_, lostElements);
+    unreportedRemovals_.clear();
+    ElementDelta delta;
+    delta.removed.assign(removed.begin(), removed.end());
+    return delta;
 }
 
-void WordSet::updateElements() noexcept {
+void WordSet::replayEdit(ElementId element, bool inserted) noexcept {
+    if (inserted) {
+        insertStored(*elements_, element);
+    } else {
+        eraseStored(*elements_, ElementSet(std::vector<ElementId>{element}));
+    }
 }
 
+std::vector<const ElementSet*> WordSet::indexedElements() const noexcept {
+    return {elements_.get()};
+}
 
-bool WordSet::addElement(const std::string& element) noexcept {
-    return elements_->insert(element).second;
+ElementSet WordSet::elementsOutsideParent() const noexcept {
+    return applySetOperation<SetOperation::DIFFERENCE>(SetView{false, elements_.get()}, parent()->view()).stored;
 }
 
-void WordSet::removedElement(const std::string& element, bool expected) noexcept {
+bool WordSet::addElement(ElementId element) noexcept {
+    bool inserted = insertStored(*elements_, element);
+    if (inserted) {
+        changed({{element}, {}});
+    }
+    return inserted;
+}
+
+void WordSet::removedElements(const ElementSet& elements, bool expected) noexcept {
+    // only the elements this set has can be unexpectedly lost
+    auto lostElements = ElementSet::intersect(*elements_, elements);
     if (!expected) {
-        handleUnexpectedWordRemoval(element);
+        for (auto element : lostElements) {
+            handleUnexpectedWordRemoval(element);
+            // the faux word set replacing this set took over its elements and subsets
+            if (becomingFaux != nullptr) {
+                return;
+            }
+        }
     }
-    for (const auto& subset : subsets_) {
-        subset.second->removedElement(element, true);
+    removedFromSubsets(elements, true);
+    eraseStored(*elements_, lostElements);
+    unreportedRemovals_ = ElementSet::unite(unreportedRemovals_, lostElements);
+}
+
+void WordSet::eraseWords(const ElementSet& words) noexcept {
+    if (words.empty()) {
+        return;
     }
-    elements_->erase(element);
+    removedFromSubsets(words, true);
+    eraseStored(*elements_, words);
 }
 
-void WordSet::handleUnexpectedWordRemoval(const std::string& element) noexcept {
-    nowide::cout << "The element '" << element << "' was attempted to be unexpectedly removed from the '" << name() << "' nested word set.\n"
+void WordSet::handleUnexpectedWordRemoval(ElementId element) noexcept {
+    nowide::cout << "The element '" << dictionary().element(element) << "' was attempted to be unexpectedly removed from the '" << name() << "' nested word set.\n"
               << "you may either delete this element, exit the program without saving, or this word set can be substituted with an Faux-Wordset which allows faux non-subsetted words\n"
               << "Enter [D] to delete the element, [E] to exit the program without saving, or [F] to substitute the WordSet with a Faux-WordSet: ";
     std::string input;
@@ -191,10 +247,11 @@ void WordSet::handleUnexpectedWordRemoval(const std::string& element) noexcept {
         if (std::toupper(input[0]) == 'D') {
             return;
         } else if (std::toupper(input[0]) == 'E') {
-            exit(0);
+            exitWithoutSaving();
         } else if (std::toupper(input[0]) == 'F') {
             elements_->insert(element);
 
+            journal_->record(EditJournal::Operation::BECOME_FAUX, *this);
             parent()->onQueryRemove = this;
             auto fauxWordSet = std::make_unique<FauxWordSet>(std::move(*this));
             becomingFaux = fauxWordSet.get();
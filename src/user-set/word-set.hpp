@@ -22,25 +22,37 @@ class WordSet : public SubSet {
         static constexpr char type_ = 'W';
         char type() const noexcept override { return type_; }
 
-        void saveMachineSubset(std::ostream& saveLocation) noexcept override;
-        void loadMachineSubset(std::istream& loadLocation) noexcept override;
-        virtual void postParentLoad() noexcept(false);
+        void saveMachineSubset(MachineWriter& saveLocation) noexcept override;
+        void loadMachineSubset(MachineReader& loadLocation) noexcept override;
         void updateElements() noexcept override;
+        ElementDelta applyDelta(const ElementDelta& inputDelta) noexcept override;
+        std::vector<const ElementSet*> indexedElements() const noexcept override;
+        ElementSet elementsOutsideParent() const noexcept override;
         // #endregion 
 
         void addWord() noexcept;
         void addParentWord() noexcept;
         void removeWord() noexcept;
         void removeContainedWord() noexcept;
-
-        bool addElement(const std::string& element) noexcept;
-        void removedElement(const std::string& element, bool expected) noexcept override;
+        void importWords() noexcept;
+
+        bool addElement(ElementId element) noexcept;
+        void removedElements(const ElementSet& elements, bool expected) noexcept override;
+    protected:
+        // #region UserSet protected members override
+        void replayEdit(ElementId element, bool inserted) noexcept override;
+        // #endregion
     private:
         // #region UserSet private members override 
         const Menu<UserSet, void>& setSpecificMenu() const noexcept override;
         // #endregion 
 
-        void handleUnexpectedWordRemoval(const std::string& element) noexcept;
+        void handleUnexpectedWordRemoval(ElementId element) noexcept;
+        // erases words, which this set has, from it and every nested subset
+        void eraseWords(const ElementSet& words) noexcept;
+
+        // the elements removedElements erased before the update that follows reached this set, which its next applyDelta reports
+        ElementSet unreportedRemovals_;
 
         FauxWordSet* becomingFaux = nullptr;
         friend class FauxWordSet;
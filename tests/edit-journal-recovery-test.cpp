@@ -0,0 +1,211 @@
+/*
+    edit-journal-recovery-test.cpp
+
+    Answers the menus of a hierarchy of a directory set with a word set in it, saving it to the default location after every word added to the word set,
+    so that it is saved in full once and journaled after, then loads what a crash could leave of those saves into other hierarchies:
+    a journal whose last batch was only partly written, a journal of a full save that was replaced since, and a journal marked by a compaction
+    that stopped before it replaced the full save, or after it did but before it rewrote the journal
+    Where the journal cannot be appended to, the next save has to be a full one, which is checked by saving again and loading that
+*/
+#include "global-set.hpp"
+
+#include "test.hpp"
+
+#include <nowide/fstream.hpp>
+#include <nowide/iostream.hpp>
+
+#include <cstdlib>
+#include <filesystem>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace {
+    std::istringstream answers;
+    std::ostringstream prompts;
+
+    const std::filesystem::path JOURNAL_LOCATION = "managed-sets.bin.journal";
+    const std::filesystem::path JOURNAL_BACKUP_LOCATION = "managed-sets.bin.journal.bak";
+
+    // makes the menus read input from here on, until it is all read
+    void answer(const std::string& input) noexcept {
+        answers.clear();
+        answers.str(input);
+    }
+
+    // adds word to the word set and saves to the default location
+    void addWord(GlobalSet& globalSet, const std::string& word) noexcept {
+        answer("E\nDIR\nE\nW\nV\nA\n" + word + "\nX\nX\nX\n");
+        globalSet.query();
+        answer("S\nd\n");
+        globalSet.query();
+    }
+
+    // the words in the word set, in order
+    std::string words(const UserSet& globalSet) noexcept {
+        auto directorySet = globalSet.subsets().find("DIR");
+        if (directorySet == globalSet.subsets().end() || directorySet->second->subsets().count("W") == 0) {
+            return "no word set";
+        }
+        const auto& wordSet = *directorySet->second->subsets().at("W");
+        std::string words;
+        for (auto element : wordSet.dictionary().sorted(*wordSet.view().stored)) {
+            if (!words.empty()) {
+                words += ' ';
+            }
+            words += wordSet.dictionary().element(element);
+        }
+        return words;
+    }
+
+    std::string readFile(const std::filesystem::path& location) noexcept {
+        nowide::ifstream file(denativePath(location), std::ios::in | std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    void writeFile(const std::filesystem::path& location, const std::string& contents) noexcept {
+        nowide::ofstream file(denativePath(location), std::ios::out | std::ios::binary);
+        file.write(contents.data(), contents.size());
+    }
+
+    // copies from to to along with when it was last written, which is part of what the journal identifies the full save by
+    void copyFile(const std::filesystem::path& from, const std::filesystem::path& to) noexcept {
+        std::filesystem::copy_file(from, to, std::filesystem::copy_options::overwrite_existing);
+        std::filesystem::last_write_time(to, std::filesystem::last_write_time(from));
+    }
+
+    // what a compaction appends to the journal once it saved the sets in full to compactedLocation, as they were once the first batches batches were saved
+    std::string mark(const std::filesystem::path& compactedLocation, size_t batches) noexcept {
+        std::ostringstream mark;
+        ElementDictionary dictionary;
+        TextMachineWriter writer(mark, dictionary);
+        writer.writeString("");
+        writer.writeSize(std::filesystem::file_size(compactedLocation));
+        writer.writeSize(static_cast<size_t>(std::filesystem::last_write_time(compactedLocation).time_since_epoch().count()));
+        writer.writeSize(batches);
+        mark << '\n';
+        return mark.str();
+    }
+
+    // puts fullSave and journal where the sets are loaded from by default, forgetting what was printed and any journal backed up before
+    void crashWith(const std::filesystem::path& fullSave, const std::string& journal) noexcept {
+        copyFile(fullSave, UserSet::DEFAULT_MACHINE_LOCATION);
+        writeFile(JOURNAL_LOCATION, journal);
+        std::filesystem::remove(JOURNAL_BACKUP_LOCATION);
+        prompts.str("");
+    }
+
+    // the words a hierarchy loaded from the default location has
+    std::string loadedWords() noexcept {
+        GlobalSet loaded;
+        loaded.loadMachineSubsets(UserSet::DEFAULT_MACHINE_LOCATION);
+        return words(loaded);
+    }
+}
+
+int main() {
+    auto directory = std::filesystem::temp_directory_path() / ("set-manager-edit-journal-recovery-test-" + std::to_string(std::random_device()()));
+    std::filesystem::create_directories(directory / "files");
+    for (const char* file : {"a", "b", "c", "d"}) {
+        nowide::ofstream(denativePath(directory / "files" / file));
+    }
+    // the default location is relative to here
+    auto workingDirectory = std::filesystem::current_path();
+    std::filesystem::current_path(directory);
+    // a load that goes wrong can ask what to do about it until the answers run out, which exits the program without saving
+    std::at_quick_exit([] {
+        nowide::cerr << "FAILED: the program exited before the test ended\n";
+        std::_Exit(1);
+    });
+    auto* cinBuffer = nowide::cin.rdbuf(answers.rdbuf());
+    auto* coutBuffer = nowide::cout.rdbuf(prompts.rdbuf());
+
+    // W = {a} saved in full, then b and c each journaled as a batch, where a compaction saved the sets in full once b was saved
+    std::string oneBatch;
+    std::string journal;
+    {
+        GlobalSet globalSet;
+        answer("C\nDIR\nD\n" + denativePath(directory / "files") + "\n");
+        globalSet.query();
+        answer("E\nDIR\nC\nW\nW\nX\n");
+        globalSet.query();
+        addWord(globalSet, "a");
+        copyFile(UserSet::DEFAULT_MACHINE_LOCATION, "full.bin");
+        addWord(globalSet, "b");
+        oneBatch = readFile(JOURNAL_LOCATION);
+        {
+            nowide::ofstream compactedFile("compacted.bin", std::ios::out | std::ios::binary);
+            globalSet.saveMachineSubsets(compactedFile);
+        }
+        addWord(globalSet, "c");
+        journal = readFile(JOURNAL_LOCATION);
+        check(readFile(UserSet::DEFAULT_MACHINE_LOCATION) == readFile("full.bin"), "saving after the first save only appended to the journal");
+        check(journal.size() > oneBatch.size() && journal.compare(0, oneBatch.size(), oneBatch) == 0, "each save appended a batch to the journal");
+    }
+
+    crashWith("full.bin", journal);
+    check(loadedWords() == "a b c", "the journal is replayed on top of the full save");
+    check(prompts.str().find("journal") == std::string::npos, "a whole journal is replayed without a message");
+
+    // the last batch is cut off anywhere before the newline after its checksum, which is not needed to read it
+    bool truncationsSkipped = true;
+    for (size_t size = oneBatch.size() + 1; size < journal.size() - 1; ++size) {
+        crashWith("full.bin", journal.substr(0, size));
+        truncationsSkipped = loadedWords() == "a b" && prompts.str().find("only partly saved") != std::string::npos && truncationsSkipped;
+    }
+    check(truncationsSkipped, "a truncated last batch is not replayed, and says so");
+    auto corruptJournal = journal;
+    corruptJournal[oneBatch.size() + (journal.size() - oneBatch.size()) / 2] ^= 0x01;
+    crashWith("full.bin", corruptJournal);
+    check(loadedWords() == "a b", "a last batch that does not match its checksum is not replayed");
+    {
+        crashWith("full.bin", journal.substr(0, journal.size() - 2));
+        GlobalSet loaded;
+        loaded.loadMachineSubsets(UserSet::DEFAULT_MACHINE_LOCATION);
+        addWord(loaded, "d");
+        check(readFile(UserSet::DEFAULT_MACHINE_LOCATION) != readFile("full.bin"), "saving after a truncated journal was loaded saves in full");
+    }
+    prompts.str("");
+    check(loadedWords() == "a b d", "what was saved in full after a truncated journal was loaded is loaded");
+    check(prompts.str().find("journal") == std::string::npos, "the journal was restarted by the full save");
+
+    // the full save was replaced since the journal was started for the one before it
+    crashWith("compacted.bin", journal);
+    check(loadedWords() == "a b", "a journal of another full save is not replayed");
+    check(prompts.str().find("is not of the sets saved at") != std::string::npos, "a journal of another full save is not replayed, and says so");
+    check(!std::filesystem::exists(JOURNAL_LOCATION) && readFile(JOURNAL_BACKUP_LOCATION) == journal, "a journal of another full save is moved out of the way");
+    {
+        GlobalSet loaded;
+        loaded.loadMachineSubsets(UserSet::DEFAULT_MACHINE_LOCATION);
+        addWord(loaded, "d");
+    }
+    check(loadedWords() == "a b d", "what was saved in full after a journal of another full save was loaded is loaded");
+
+    // the compaction marked the journal, after c was saved while it was running, but stopped before it replaced the full save
+    auto markedJournal = journal + mark("compacted.bin", 1);
+    crashWith("full.bin", markedJournal);
+    check(loadedWords() == "a b c", "a journal marked by a compaction that did not replace the full save is replayed in full");
+    check(prompts.str().find("journal") == std::string::npos, "a journal marked by a compaction that did not replace the full save is replayed without a message");
+
+    // the compaction replaced the full save, but stopped before it rewrote the journal
+    crashWith("compacted.bin", markedJournal);
+    {
+        GlobalSet loaded;
+        loaded.loadMachineSubsets(UserSet::DEFAULT_MACHINE_LOCATION);
+        check(words(loaded) == "a b c", "a journal marked by a compaction that replaced the full save is replayed from the batches it did not save");
+        check(prompts.str().find("journal") == std::string::npos, "a journal marked by a compaction that replaced the full save is replayed without a message");
+        addWord(loaded, "d");
+        check(readFile(UserSet::DEFAULT_MACHINE_LOCATION) == readFile("compacted.bin"), "saving after a journal marked by a compaction was loaded only appends to it");
+    }
+    check(loadedWords() == "a b c d", "what was journaled after a journal marked by a compaction was loaded is replayed");
+
+    answers >> std::ws;
+    check(answers.eof(), "every answer was read");
+
+    nowide::cin.rdbuf(cinBuffer);
+    nowide::cout.rdbuf(coutBuffer);
+    std::filesystem::current_path(workingDirectory);
+    std::filesystem::remove_all(directory);
+    return testResult();
+}
\ No newline at end of file
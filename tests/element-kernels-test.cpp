@@ -0,0 +1,139 @@
+/*
+    element-kernels-test.cpp
+
+    Checks every operation of every implementation of the merge kernels the running processor supports against std::set_* on random sorted arrays,
+    of every length around the blocks the vectorized kernels work on, and of lengths skewed enough to gallop
+*/
+#include "element-kernels.hpp"
+
+#include "test.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    // sorted unique ids drawn from [low, low + range), so that a small range makes both arrays share most of their ids and a large one few
+    std::vector<ElementId> randomIds(std::mt19937& random, size_t size, ElementId low, uint64_t range) noexcept {
+        std::uniform_int_distribution<uint64_t> distribution(0, range - 1);
+        std::vector<ElementId> ids;
+        ids.reserve(size);
+        while (ids.size() < size) {
+            for (size_t i = ids.size(); i < size; ++i) {
+                ids.push_back(static_cast<ElementId>(low + distribution(random)));
+            }
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        }
+        return ids;
+    }
+
+    template<typename Expected>
+    void checkOperation(
+        const char* operation,
+        void (*kernel)(const std::vector<ElementId>&, const std::vector<ElementId>&, std::vector<ElementId>&) noexcept,
+        Expected expected,
+        const std::vector<ElementId>& ids1,
+        const std::vector<ElementId>& ids2,
+        const std::string& description
+    ) noexcept {
+        std::vector<ElementId> expectedResult;
+        expected(ids1.begin(), ids1.end(), ids2.begin(), ids2.end(), std::back_inserter(expectedResult));
+        // results are appended to whatever was in the vector before, which the kernels have to overwrite
+        std::vector<ElementId> result(3, 7);
+        kernel(ids1, ids2, result);
+        check(result == expectedResult, std::string(operation) + " of " + description);
+    }
+
+    void checkAllOperations(const std::vector<ElementId>& ids1, const std::vector<ElementId>& ids2, const std::string& description) noexcept {
+        auto intersection = [](auto... arguments) { std::set_intersection(arguments...); };
+        auto unionOf = [](auto... arguments) { std::set_union(arguments...); };
+        auto difference = [](auto... arguments) { std::set_difference(arguments...); };
+        auto symmetricDifference = [](auto... arguments) { std::set_symmetric_difference(arguments...); };
+        for (int swapped = 0; swapped < 2; ++swapped) {
+            const auto& first = swapped ? ids2 : ids1;
+            const auto& second = swapped ? ids1 : ids2;
+            auto ordered = description + (swapped ? " swapped" : "");
+            checkOperation("intersection", intersectSorted, intersection, first, second, ordered);
+            checkOperation("union", uniteSorted, unionOf, first, second, ordered);
+            checkOperation("difference", differenceSorted, difference, first, second, ordered);
+            checkOperation("symmetric difference", symmetricDifferenceSorted, symmetricDifference, first, second, ordered);
+        }
+    }
+
+    const char* levelName(KernelLevel level) noexcept {
+        switch (level) {
+            case KernelLevel::AVX2:
+                return "AVX2";
+            case KernelLevel::SSE4_2:
+                return "SSE4.2";
+            default:
+                return "scalar";
+        }
+    }
+}
+
+int main() {
+    std::vector<KernelLevel> levels = {KernelLevel::SCALAR};
+    if (supportedKernelLevel() >= KernelLevel::SSE4_2) {
+        levels.push_back(KernelLevel::SSE4_2);
+    }
+    if (supportedKernelLevel() >= KernelLevel::AVX2) {
+        levels.push_back(KernelLevel::AVX2);
+    }
+
+    // every length up to a few blocks of 8, and lengths on either side of larger block boundaries
+    std::vector<size_t> sizes;
+    for (size_t size = 0; size <= 40; ++size) {
+        sizes.push_back(size);
+    }
+    for (size_t size : {63, 64, 65, 127, 128, 129, 1000, 1023, 1024, 1025}) {
+        sizes.push_back(size);
+    }
+
+    for (auto level : levels) {
+        useKernelLevel(level);
+        std::mt19937 random(5489);
+        for (size_t size1 : sizes) {
+            for (size_t size2 : sizes) {
+                // ranges twice the arrays overlap in about half their ids, ranges far larger barely overlap,
+                // and ranges ending at the largest id check that it is never mistaken for anything the kernels pad with
+                for (uint64_t rangeFactor : {2, 64}) {
+                    auto range = std::max<uint64_t>(std::max(size1, size2) * rangeFactor, 16);
+                    auto description = std::string(levelName(level)) + " arrays of " + std::to_string(size1) + " and " + std::to_string(size2) + " ids from " + std::to_string(range);
+                    checkAllOperations(randomIds(random, size1, 0, range), randomIds(random, size2, 0, range), description);
+                }
+                auto range = std::max<uint64_t>(std::max(size1, size2) * 2, 16);
+                checkAllOperations(
+                    randomIds(random, size1, static_cast<ElementId>(UINT32_MAX - range + 1), range),
+                    randomIds(random, size2, static_cast<ElementId>(UINT32_MAX - range + 1), range),
+                    std::string(levelName(level)) + " arrays of " + std::to_string(size1) + " and " + std::to_string(size2) + " ids ending at the largest id"
+                );
+            }
+        }
+        // identical arrays, and arrays with no ids in common on either side of each other
+        for (size_t size : sizes) {
+            auto ids = randomIds(random, size, 0, size * 4 + 16);
+            checkAllOperations(ids, ids, std::string(levelName(level)) + " identical arrays of " + std::to_string(size) + " ids");
+            std::vector<ElementId> above;
+            for (auto id : ids) {
+                above.push_back(id + size * 4 + 16);
+            }
+            checkAllOperations(ids, above, std::string(levelName(level)) + " disjoint arrays of " + std::to_string(size) + " ids");
+        }
+        // arrays skewed enough to be galloped through rather than merged
+        for (size_t smallSize : {1, 3, 17}) {
+            for (size_t largeSize : {GALLOP_RATIO * 17 + 1, size_t(100000)}) {
+                checkAllOperations(
+                    randomIds(random, smallSize, 0, largeSize * 2),
+                    randomIds(random, largeSize, 0, largeSize * 2),
+                    std::string(levelName(level)) + " skewed arrays of " + std::to_string(smallSize) + " and " + std::to_string(largeSize) + " ids"
+                );
+            }
+        }
+    }
+    useKernelLevel(supportedKernelLevel());
+    return testResult();
+}
\ No newline at end of file
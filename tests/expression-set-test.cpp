@@ -0,0 +1,279 @@
+/*
+    expression-set-test.cpp
+
+    Checks the programs expressions compile into, for precedence, associativity, quoting, the expansion of ~ and the errors of invalid expressions,
+    then builds expression sets over finite and infinite operands, within an infinite and a finite parent, and checks the elements each one holds,
+    both when it is first computed and after its operands change, against the same expression computed one operation at a time with applySetOperation
+*/
+#include "global-set.hpp"
+#include "expression-set.hpp"
+
+#include "test.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+    // a program as its operations, with every operand pushed followed by its index
+    std::string render(const std::vector<ExpressionSet::Instruction>& program) noexcept {
+        std::string rendered;
+        for (const auto& instruction : program) {
+            if (!rendered.empty()) {
+                rendered += ' ';
+            }
+            rendered += char(instruction.operation);
+            if (instruction.operation == ExpressionSet::Instruction::PUSH_OPERAND) {
+                rendered += std::to_string(instruction.operand);
+            }
+        }
+        return rendered;
+    }
+
+    void checkCompiles(const std::string& expression, const std::string& program, const std::vector<std::string>& operandNames) noexcept {
+        std::vector<ExpressionSet::Instruction> compiled;
+        std::vector<std::string> compiledNames;
+        std::string error;
+        if (!check(ExpressionSet::compile(expression, compiled, compiledNames, error), "'" + expression + "' compiles, instead of: " + error)) {
+            return;
+        }
+        check(render(compiled) == program, "'" + expression + "' compiles to " + program + " rather than " + render(compiled));
+        check(compiledNames == operandNames, "'" + expression + "' names its operands in the order they first appear");
+    }
+
+    void checkFails(const std::string& expression) noexcept {
+        std::vector<ExpressionSet::Instruction> compiled;
+        std::vector<std::string> compiledNames;
+        std::string error;
+        check(!ExpressionSet::compile(expression, compiled, compiledNames, error) && !error.empty(), "'" + expression + "' is refused with an error");
+    }
+
+    // a set of the elements it was given, or of every element but those, which only changes when it is edited
+    class FixedSet : public SubSet {
+        public:
+            FixedSet(UserSet* parent, const std::string& name, bool complemented, const std::vector<ElementId>& stored) noexcept
+                : SubSet(parent, name)
+            {
+                assign({complemented, ElementSet(stored)});
+            }
+
+            char type() const noexcept override { return 'W'; }
+            void saveMachineSubset(MachineWriter&) noexcept override {}
+            void loadMachineSubset(MachineReader&) noexcept override {}
+            void updateElements() noexcept override {}
+
+            // makes element a member of the set, or not, and updates the sets computed from it with only that change
+            void edit(ElementId element, bool member) noexcept {
+                auto& stored = elements_ != nullptr ? *elements_ : *complementElements_;
+                if (member == (elements_ != nullptr)) {
+                    insertStored(stored, element);
+                } else {
+                    eraseStored(stored, ElementSet(std::vector<ElementId>{element}));
+                }
+                ElementDelta delta;
+                (member ? delta.added : delta.removed).push_back(element);
+                changed(std::move(delta));
+            }
+    };
+
+    SetValue valueOf(const UserSet& set) noexcept {
+        auto view = set.view();
+        return {view.complemented, *view.stored};
+    }
+
+    template <SetOperation Operation>
+    SetValue apply(const SetValue& set1, const SetValue& set2) noexcept {
+        return applySetOperation<Operation>(SetView{set1.complemented, &set1.stored}, SetView{set2.complemented, &set2.stored});
+    }
+
+    struct Case {
+        std::string expression;
+        // the expression computed one operation at a time from the values of the parent and of the sets it names
+        std::function<SetValue(const std::function<SetValue(const std::string&)>& at)> expected;
+    };
+
+    // the sets the cases are evaluated over, and an expression set for each case
+    class Hierarchy {
+        public:
+            Hierarchy(UserSet& globalSet, bool complemented, const std::vector<ElementId>& stored) noexcept
+                : parent_(&globalSet, "PARENT", complemented, stored)
+            {}
+
+            FixedSet& addOperand(const std::string& name, bool complemented, const std::vector<ElementId>& stored) noexcept {
+                return *operands_.emplace(name, std::make_unique<FixedSet>(&parent_, name, complemented, stored)).first->second;
+            }
+
+            FixedSet& parent() noexcept {
+                return parent_;
+            }
+
+            void addExpressionSets(const std::vector<Case>& cases) noexcept {
+                for (const auto& expressionCase : cases) {
+                    std::vector<ExpressionSet::Instruction> program;
+                    std::vector<std::string> operandNames;
+                    std::string error;
+                    ExpressionSet::compile(expressionCase.expression, program, operandNames, error);
+                    std::vector<UserSet*> userSets;
+                    for (const auto& operandName : operandNames) {
+                        userSets.push_back(operands_.at(operandName).get());
+                    }
+                    expressionSets_.push_back(std::make_unique<ExpressionSet>(&parent_, expressionCase.expression, std::move(userSets), expressionCase.expression, std::move(program)));
+                }
+            }
+
+            void check(const std::vector<Case>& cases, const std::string& when) noexcept {
+                auto at = [this](const std::string& name) {
+                    return name.empty() ? valueOf(parent_) : valueOf(*operands_.at(name));
+                };
+                for (size_t i = 0; i < cases.size(); ++i) {
+                    auto expected = cases[i].expected(at);
+                    auto actual = valueOf(*expressionSets_.at(i));
+                    ::check(
+                        actual.complemented == expected.complemented && std::equal(actual.stored.begin(), actual.stored.end(), expected.stored.begin(), expected.stored.end()),
+                        "'" + cases[i].expression + "' holds the elements of the expression " + when
+                    );
+                }
+            }
+        private:
+            FixedSet parent_;
+            std::map<std::string, std::unique_ptr<FixedSet>> operands_;
+            // destroyed before the sets they are computed from
+            std::vector<std::unique_ptr<ExpressionSet>> expressionSets_;
+    };
+}
+
+int main() {
+    checkCompiles("A | B & C", "o0 o1 o2 & |", {"A", "B", "C"});
+    checkCompiles("(A | B) & C", "o0 o1 | o2 &", {"A", "B", "C"});
+    checkCompiles("A ^ B | C ^ D", "o0 o1 ^ o2 o3 ^ |", {"A", "B", "C", "D"});
+    checkCompiles("A & B ^ C - D", "o0 o1 & o2 o3 - ^", {"A", "B", "C", "D"});
+    checkCompiles("A - B - C", "o0 o1 - o2 -", {"A", "B", "C"});
+    checkCompiles("~A & B", "p o0 - o1 &", {"A", "B"});
+    checkCompiles("~~A", "p p o0 - -", {"A"});
+    checkCompiles("~(A | B)", "p o0 o1 | -", {"A", "B"});
+    checkCompiles("B & A | A", "o0 o1 & o1 |", {"B", "A"});
+    checkCompiles("\"a set\" | \"x|y\"&z", "o0 o1 o2 & |", {"a set", "x|y", "z"});
+    checkCompiles("  A|B  ", "o0 o1 |", {"A", "B"});
+
+    checkFails("");
+    checkFails("A |");
+    checkFails("(A | B");
+    checkFails("A | B)");
+    checkFails("A B");
+    checkFails("\"A");
+    checkFails("\"\"");
+    checkFails("~");
+    // every nested union keeps its left operand on the stack, so nesting them 64 deep needs a stack of 65
+    std::string nested = "A";
+    for (size_t depth = 1; depth < ExpressionSet::MAX_STACK_DEPTH; ++depth) {
+        nested = "A | (" + nested + ")";
+    }
+    checkCompiles(nested, [] {
+        std::string program;
+        for (size_t depth = 0; depth < ExpressionSet::MAX_STACK_DEPTH; ++depth) {
+            program += program.empty() ? "o0" : " o0";
+        }
+        for (size_t depth = 1; depth < ExpressionSet::MAX_STACK_DEPTH; ++depth) {
+            program += " |";
+        }
+        return program;
+    }(), {"A"});
+    checkFails("A | (" + nested + ")");
+
+    GlobalSet globalSet;
+    auto& dictionary = globalSet.dictionary();
+    ElementId a = dictionary.intern("a");
+    ElementId b = dictionary.intern("b");
+    ElementId c = dictionary.intern("c");
+    ElementId d = dictionary.intern("d");
+    ElementId e = dictionary.intern("e");
+    ElementId f = dictionary.intern("f");
+
+    // within an infinite parent, the complements of A and B are infinite too
+    Hierarchy infinite(globalSet, true, {});
+    auto& setA = infinite.addOperand("A", false, {a, b, c});
+    infinite.addOperand("B", false, {b, c, d});
+    auto& setC = infinite.addOperand("C", false, {c, e});
+    auto& notA = infinite.addOperand("NOT A", true, {a, b, c});
+    auto& notB = infinite.addOperand("NOT B", true, {b, c, d});
+    const std::vector<Case> infiniteCases = {
+        {"A | B & C", [](const auto& at) {
+            return apply<SetOperation::UNITE>(at("A"), apply<SetOperation::INTERSECT>(at("B"), at("C")));
+        }},
+        {"(A | B) & C", [](const auto& at) {
+            return apply<SetOperation::INTERSECT>(apply<SetOperation::UNITE>(at("A"), at("B")), at("C"));
+        }},
+        {"A ^ B | C", [](const auto& at) {
+            return apply<SetOperation::UNITE>(apply<SetOperation::SYMMETRIC_DIFFERENCE>(at("A"), at("B")), at("C"));
+        }},
+        {"~A", [](const auto& at) {
+            return apply<SetOperation::DIFFERENCE>(at(""), at("A"));
+        }},
+        {"~A & B", [](const auto& at) {
+            return apply<SetOperation::INTERSECT>(apply<SetOperation::DIFFERENCE>(at(""), at("A")), at("B"));
+        }},
+        {"~(A | \"NOT B\")", [](const auto& at) {
+            return apply<SetOperation::DIFFERENCE>(at(""), apply<SetOperation::UNITE>(at("A"), at("NOT B")));
+        }},
+        {"\"NOT A\" | B", [](const auto& at) {
+            return apply<SetOperation::UNITE>(at("NOT A"), at("B"));
+        }},
+        {"\"NOT A\" & \"NOT B\"", [](const auto& at) {
+            return apply<SetOperation::INTERSECT>(at("NOT A"), at("NOT B"));
+        }},
+        {"\"NOT A\" - C", [](const auto& at) {
+            return apply<SetOperation::DIFFERENCE>(at("NOT A"), at("C"));
+        }},
+        {"A - \"NOT B\"", [](const auto& at) {
+            return apply<SetOperation::DIFFERENCE>(at("A"), at("NOT B"));
+        }},
+        {"\"NOT A\" - \"NOT B\"", [](const auto& at) {
+            return apply<SetOperation::DIFFERENCE>(at("NOT A"), at("NOT B"));
+        }},
+        {"\"NOT A\" ^ B", [](const auto& at) {
+            return apply<SetOperation::SYMMETRIC_DIFFERENCE>(at("NOT A"), at("B"));
+        }},
+        {"\"NOT A\" ^ \"NOT B\" ^ C", [](const auto& at) {
+            return apply<SetOperation::SYMMETRIC_DIFFERENCE>(apply<SetOperation::SYMMETRIC_DIFFERENCE>(at("NOT A"), at("NOT B")), at("C"));
+        }},
+        {"~\"NOT A\" | C - A", [](const auto& at) {
+            return apply<SetOperation::UNITE>(apply<SetOperation::DIFFERENCE>(at(""), at("NOT A")), apply<SetOperation::DIFFERENCE>(at("C"), at("A")));
+        }}
+    };
+    infinite.addExpressionSets(infiniteCases);
+    infinite.check(infiniteCases, "when it is first computed");
+
+    // every expression set was just read, so each of them applies these edits to the elements it holds rather than being computed again
+    setA.edit(f, true);
+    setA.edit(b, false);
+    setC.edit(a, true);
+    notA.edit(a, true);
+    notB.edit(f, false);
+    infinite.check(infiniteCases, "after its operands changed");
+
+    // within a finite parent, complements are finite as well
+    Hierarchy finite(globalSet, false, {a, b, c, d, e});
+    finite.addOperand("X", false, {a, b});
+    finite.addOperand("Y", false, {b, c});
+    const std::vector<Case> finiteCases = {
+        {"~X", [](const auto& at) {
+            return apply<SetOperation::DIFFERENCE>(at(""), at("X"));
+        }},
+        {"~X & ~Y", [](const auto& at) {
+            return apply<SetOperation::INTERSECT>(apply<SetOperation::DIFFERENCE>(at(""), at("X")), apply<SetOperation::DIFFERENCE>(at(""), at("Y")));
+        }},
+        {"~(X | Y) ^ X", [](const auto& at) {
+            return apply<SetOperation::SYMMETRIC_DIFFERENCE>(apply<SetOperation::DIFFERENCE>(at(""), apply<SetOperation::UNITE>(at("X"), at("Y"))), at("X"));
+        }}
+    };
+    finite.addExpressionSets(finiteCases);
+    finite.check(finiteCases, "within a finite parent");
+    finite.parent().edit(f, true);
+    finite.parent().edit(c, false);
+    finite.check(finiteCases, "after its finite parent changed");
+
+    return testResult();
+}
\ No newline at end of file
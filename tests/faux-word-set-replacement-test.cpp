@@ -0,0 +1,78 @@
+/*
+    faux-word-set-replacement-test.cpp
+
+    Answers the menus of a hierarchy of a directory set with a word set of one of its file names nested in it, deletes the file,
+    and substitutes the word set with a faux word set when the update finds its word missing, then checks the hierarchy by entering the replacement
+    and finding the word, which crashed when the replaced word set was detached after handing its elements over
+    Finding a word that was never entered afterwards checks that looking for it does not add it to the dictionary
+*/
+#include "global-set.hpp"
+#include "faux-word-set.hpp"
+
+#include "test.hpp"
+
+#include <nowide/fstream.hpp>
+#include <nowide/iostream.hpp>
+
+#include <filesystem>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace {
+    std::istringstream answers;
+    std::ostringstream prompts;
+
+    // makes the menus read input from here on, until it is all read
+    void answer(const std::string& input) noexcept {
+        answers.clear();
+        answers.str(input);
+    }
+}
+
+int main() {
+    auto directory = std::filesystem::temp_directory_path() / ("set-manager-faux-word-set-test-" + std::to_string(std::random_device()()));
+    std::filesystem::create_directories(directory);
+    for (const char* file : {"word", "other"}) {
+        nowide::ofstream(denativePath(directory / file));
+    }
+    auto* cinBuffer = nowide::cin.rdbuf(answers.rdbuf());
+    auto* coutBuffer = nowide::cout.rdbuf(prompts.rdbuf());
+
+    {
+        GlobalSet globalSet;
+        answer("C\nDIR\nD\n" + denativePath(directory) + "\n");
+        globalSet.query();
+        answer("E\nDIR\nC\nWORDS\nW\nE\nWORDS\nV\nA\nword\nX\nX\nX\n");
+        globalSet.query();
+
+        std::filesystem::remove(directory / "word");
+        // updates the directory set, substitutes the word set, then enters the replacement and finds the word from within it before leaving
+        answer("E\nDIR\nU\nF\nE\nWORDS\nF\nword\nX\nX\n");
+        globalSet.query();
+        answers >> std::ws;
+        check(answers.eof(), "every answer was read");
+
+        const auto& directorySet = *globalSet.subsets().at("DIR");
+        const auto& words = *directorySet.subsets().at("WORDS");
+        check(words.type() == FauxWordSet::type_, "the word set was substituted with a faux word set");
+        auto stored = words.indexedElements();
+        check(stored.size() == 2 && stored[0]->size() == 1 && stored[1]->empty(), "the word the parent lost became the only faux element");
+        check(globalSet.containingSets(std::string_view("word")).empty(), "no set contains the word the parent lost");
+        auto containing = globalSet.containingSets(std::string_view("other"));
+        check(containing.size() == 1 && containing.front() == &directorySet, "only the directory set contains the file left in it");
+
+        auto dictionarySize = globalSet.dictionary().size();
+        prompts.str("");
+        answer("F\nnever entered\n");
+        globalSet.query();
+        ElementId neverEntered;
+        check(!globalSet.dictionary().find("never entered", neverEntered) && globalSet.dictionary().size() == dictionarySize, "finding a word does not intern it");
+        check(prompts.str().find("Containing set list\n" + std::string(80, '-') + '\n' + std::string(80, '-')) != std::string::npos, "no set contains a word that was never entered");
+    }
+
+    nowide::cin.rdbuf(cinBuffer);
+    nowide::cout.rdbuf(coutBuffer);
+    std::filesystem::remove_all(directory);
+    return testResult();
+}
\ No newline at end of file
@@ -0,0 +1,367 @@
+/*
+    machine-format-test.cpp
+
+    Writes a tree of records in both encodings of the machine format and reads each back from a stream and from a mapped file,
+    then reads every truncation of them, and of them with corrupt bytes, checking that the readers report an error rather than crash or read past the end,
+    and that nothing is read after it
+    Then answers the menus of a hierarchy of every kind of set that can be saved, saves it in both encodings, and loads each into another hierarchy,
+    from a stream and from a file, which has to hold the same sets as the one that was saved
+*/
+#include "global-set.hpp"
+#include "machine-format.hpp"
+
+#include "test.hpp"
+
+#include <nowide/fstream.hpp>
+#include <nowide/iostream.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    std::istringstream answers;
+    std::ostringstream prompts;
+
+    // makes the menus read input from here on, until it is all read
+    void answer(const std::string& input) noexcept {
+        answers.clear();
+        answers.str(input);
+    }
+
+    // what a set writes to its record, which is a section of a size followed by that many strings and then its elements, with the records of its subsets after it
+    struct Record {
+        char type;
+        bool humanIncluded;
+        std::string name;
+        std::vector<std::string> strings;
+        // sorted, which is the order they are read back in once they are sorted by their strings
+        std::vector<std::string> elements;
+        std::vector<Record> subsets;
+    };
+
+    void write(MachineWriter& saveLocation, const Record& record, const ElementDictionary& dictionary) noexcept {
+        saveLocation.beginSet(record.type, record.humanIncluded, record.name);
+        saveLocation.writeSize(record.strings.size());
+        for (const auto& string : record.strings) {
+            saveLocation.writeString(string);
+        }
+        std::vector<ElementId> elements;
+        for (const auto& element : record.elements) {
+            ElementId id;
+            dictionary.find(element, id);
+            elements.push_back(id);
+        }
+        saveLocation.writeElements(ElementSet(elements));
+        saveLocation.endSet();
+        for (const auto& subset : record.subsets) {
+            write(saveLocation, subset, dictionary);
+        }
+        saveLocation.endSubsets();
+    }
+
+    void intern(const Record& record, ElementDictionary& dictionary) noexcept {
+        for (const auto& element : record.elements) {
+            dictionary.intern(element);
+        }
+        for (const auto& subset : record.subsets) {
+            intern(subset, dictionary);
+        }
+    }
+
+    // reads everything record was written as, whatever is read instead, returning whether all of it was what was written
+    bool readBack(MachineReader& loadLocation, const Record& record, const ElementDictionary& dictionary) noexcept {
+        char type = '\0';
+        bool humanIncluded = false;
+        std::string name;
+        bool matched = loadLocation.beginSet(type, humanIncluded, name);
+        matched = type == record.type && humanIncluded == record.humanIncluded && name == record.name && matched;
+        matched = loadLocation.readSize() == record.strings.size() && matched;
+        for (const auto& string : record.strings) {
+            matched = loadLocation.readString() == string && matched;
+        }
+        std::vector<std::string> elements;
+        for (auto element : loadLocation.readElements()) {
+            elements.emplace_back(dictionary.element(element));
+        }
+        std::sort(elements.begin(), elements.end());
+        matched = elements == record.elements && matched;
+        loadLocation.endSet();
+        for (const auto& subset : record.subsets) {
+            matched = readBack(loadLocation, subset, dictionary) && matched;
+        }
+        // the records of the subsets end here
+        return !loadLocation.beginSet(type, humanIncluded, name) && matched;
+    }
+
+    // whether loadLocation holds nothing more to read, which is all that is left once it reports an error
+    bool readsNothing(MachineReader& loadLocation) noexcept {
+        char type = '\0';
+        bool humanIncluded = false;
+        std::string name;
+        return !loadLocation.beginSet(type, humanIncluded, name) && loadLocation.readSize() == 0 && loadLocation.readString().empty() && loadLocation.readElements().empty();
+    }
+
+    enum class Outcome {
+        READ,
+        MISMATCHED,
+        FAILED,
+        // something was read after an error was reported
+        READ_AFTER_FAILING
+    };
+
+    Outcome read(MachineReader& loadLocation, const Record& record, const ElementDictionary& dictionary, bool text) noexcept {
+        bool matched = readBack(loadLocation, record, dictionary);
+        if (!loadLocation.error().empty()) {
+            return readsNothing(loadLocation) ? Outcome::FAILED : Outcome::READ_AFTER_FAILING;
+        }
+        if (text && !static_cast<TextMachineReader&>(loadLocation).atEnd()) {
+            return Outcome::MISMATCHED;
+        }
+        return matched ? Outcome::READ : Outcome::MISMATCHED;
+    }
+
+    Outcome readStream(const std::string& saved, const Record& record, bool text) noexcept {
+        ElementDictionary dictionary;
+        std::istringstream loadLocation(saved);
+        if (text) {
+            TextMachineReader reader(loadLocation, dictionary);
+            return read(reader, record, dictionary, true);
+        }
+        BinaryMachineReader reader(loadLocation, dictionary);
+        return read(reader, record, dictionary, false);
+    }
+
+    Outcome readMapped(const std::filesystem::path& location, const std::string& saved, const Record& record, bool text) noexcept {
+        {
+            nowide::ofstream saveLocation(denativePath(location), std::ios::out | std::ios::binary);
+            saveLocation.write(saved.data(), saved.size());
+        }
+        auto mappedFile = std::make_shared<const MappedFile>(location);
+        if (!mappedFile->mapped()) {
+            return Outcome::MISMATCHED;
+        }
+        ElementDictionary dictionary;
+        if (text) {
+            TextMachineReader reader(mappedFile, dictionary);
+            return read(reader, record, dictionary, true);
+        }
+        BinaryMachineReader reader(mappedFile, dictionary);
+        return read(reader, record, dictionary, false);
+    }
+
+    std::string varint(size_t value) noexcept {
+        std::string bytes;
+        for (; value >= 0x80; value >>= 7) {
+            bytes.push_back(static_cast<char>(value | 0x80));
+        }
+        bytes.push_back(static_cast<char>(value));
+        return bytes;
+    }
+
+    std::string section(const std::string& contents) noexcept {
+        return varint(contents.size()) + contents;
+    }
+
+    // a binary encoding written by hand, of the element strings "a" and "b", and a record whose section is sectionContents
+    std::string binaryRecord(const std::string& sectionContents, const std::string& version = varint(1)) noexcept {
+        return "\x89SET" + version + section(varint(2) + section("a") + section("b")) + "W\x01" + section("n") + section(sectionContents) + std::string(1, '\0');
+    }
+
+    // the name, type, human inclusion and elements of set and its subsets, with the elements of faux word sets that are not in their parent
+    void describe(const UserSet& set, std::string& description) noexcept {
+        auto view = set.view();
+        description += std::string(set.name()) + ' ' + set.type() + ' ' + (set.humanIncluded ? "human " : "") + (view.complemented ? "all but " : "") + "{";
+        for (auto element : set.dictionary().sorted(*view.stored)) {
+            description += ' ' + std::string(set.dictionary().element(element));
+        }
+        description += " } stored {";
+        for (const auto* elements : set.indexedElements()) {
+            for (auto element : set.dictionary().sorted(*elements)) {
+                description += ' ' + std::string(set.dictionary().element(element));
+            }
+        }
+        description += " } (";
+        for (const auto& subset : set.subsets()) {
+            describe(*subset.second, description);
+        }
+        description += ")\n";
+    }
+
+    std::string describe(const UserSet& set) noexcept {
+        std::string description;
+        describe(set, description);
+        return description;
+    }
+
+    std::string humanOutput(UserSet& set) noexcept {
+        std::ostringstream saveLocation;
+        set.saveHumanSubsets(saveLocation);
+        return saveLocation.str();
+    }
+}
+
+int main() {
+    auto directory = std::filesystem::temp_directory_path() / ("set-manager-machine-format-test-" + std::to_string(std::random_device()()));
+    std::filesystem::create_directories(directory / "files");
+    for (const char* file : {"a", "b", "c", "with space"}) {
+        nowide::ofstream(denativePath(directory / "files" / file));
+    }
+    // anything backed up when loading fails is written next to the default location, which is relative to here
+    auto workingDirectory = std::filesystem::current_path();
+    std::filesystem::current_path(directory);
+    // a load that goes wrong can ask what to do about it until the answers run out, which exits the program without saving
+    std::at_quick_exit([] {
+        nowide::cerr << "FAILED: the program exited before the test ended\n";
+        std::_Exit(1);
+    });
+    auto* cinBuffer = nowide::cin.rdbuf(answers.rdbuf());
+    auto* coutBuffer = nowide::cout.rdbuf(prompts.rdbuf());
+
+    {
+        std::vector<std::string> many;
+        for (int element = 0; element < 150; ++element) {
+            many.push_back("element " + std::to_string(element));
+        }
+        std::sort(many.begin(), many.end());
+        Record record{'G', true, "Global", {}, {}, {
+            {'W', true, "words", {"", "two\nlines", std::string(200, 's')}, {"a", "with space"}, {
+                {'F', false, "nested", {}, {"a"}, {}}
+            }},
+            {'W', true, "many", {}, many, {}},
+            {'D', false, "", {"0 leading"}, {}, {}}
+        }};
+        ElementDictionary dictionary;
+        intern(record, dictionary);
+
+        std::ostringstream textStream;
+        {
+            TextMachineWriter writer(textStream, dictionary);
+            write(writer, record, dictionary);
+        }
+        std::ostringstream binaryStream;
+        {
+            MachineElementCollector savedElements(dictionary);
+            write(savedElements, record, dictionary);
+            BinaryMachineWriter writer(binaryStream, dictionary, savedElements.elements());
+            write(writer, record, dictionary);
+        }
+        auto mappedLocation = directory / "mapped";
+        for (bool text : {true, false}) {
+            auto saved = text ? textStream.str() : binaryStream.str();
+            check(isBinaryMachineFormat(saved) == !text, "the encoding is detected from the first byte");
+            check(readStream(saved, record, text) == Outcome::READ, "the records are read back from a stream");
+            check(readMapped(mappedLocation, saved, record, text) == Outcome::READ, "the records are read back from a mapped file");
+
+            // the text encoding ends with whitespace that is not needed to read it
+            auto end = text ? saved.find_last_not_of(" \n") + 1 : saved.size();
+            bool truncationsFail = true;
+            for (size_t size = 0; size < end; ++size) {
+                truncationsFail = readStream(saved.substr(0, size), record, text) == Outcome::FAILED && truncationsFail;
+                if (size > 0) {
+                    truncationsFail = readMapped(mappedLocation, saved.substr(0, size), record, text) == Outcome::FAILED && truncationsFail;
+                }
+            }
+            check(truncationsFail, text ? "every truncation of the text encoding is an error" : "every truncation of the binary encoding is an error");
+
+            bool corruptionsHandled = true;
+            for (size_t position = 0; position < saved.size(); ++position) {
+                for (unsigned char flip : {0x01, 0x30, 0x80, 0xff}) {
+                    auto corrupt = saved;
+                    corrupt[position] = static_cast<char>(corrupt[position] ^ flip);
+                    corruptionsHandled = readStream(corrupt, record, text) != Outcome::READ_AFTER_FAILING && corruptionsHandled;
+                }
+            }
+            check(corruptionsHandled, text ? "nothing is read after a corrupt byte of the text encoding is an error" : "nothing is read after a corrupt byte of the binary encoding is an error");
+        }
+
+        Record handWritten{'W', true, "n", {}, {"b"}, {}};
+        check(readStream(binaryRecord(varint(0) + varint(1) + varint(1)), handWritten, false) == Outcome::READ, "the binary encoding written by hand is read");
+        check(readStream("\x89SEX" + binaryRecord(varint(0) + varint(1) + varint(1)).substr(4), handWritten, false) == Outcome::FAILED, "a wrong magic number is an error");
+        check(readStream(binaryRecord(varint(0) + varint(1) + varint(1), varint(2)), handWritten, false) == Outcome::FAILED, "an unsupported version is an error");
+        check(readStream(binaryRecord(varint(0) + varint(1) + varint(2)), handWritten, false) == Outcome::FAILED, "an element past the saved element strings is an error");
+        check(readStream(binaryRecord(varint(0) + varint(1) + varint(1) + "x"), handWritten, false) == Outcome::FAILED, "a section holding more than is read is an error");
+        check(readStream(binaryRecord(varint(0) + varint(1) + std::string(10, '\xff')), handWritten, false) == Outcome::FAILED, "a size too large for a varint is an error");
+        check(readStream(binaryRecord(varint(1) + varint(9) + "ab"), handWritten, false) == Outcome::FAILED, "a string longer than its section is an error");
+        auto longSection = binaryRecord(varint(0) + varint(1) + varint(1));
+        longSection.replace(longSection.size() - 5, 1, varint(100));
+        check(readStream(longSection, handWritten, false) == Outcome::FAILED, "a section longer than what is left is an error");
+
+        check(readStream("W 1 1 n 0 1 1 b\n0\n", handWritten, true) == Outcome::READ, "the text encoding written by hand is read");
+        check(readStream("W 1 1 n x", handWritten, true) == Outcome::FAILED, "a size that is not a number is an error");
+        check(readStream("W 1 1 n 0 1 9 b\n0\n", handWritten, true) == Outcome::FAILED, "a string past the end is an error");
+        check(readStream("W 1 1 n 0 1 1 b\n", handWritten, true) == Outcome::FAILED, "records that do not end are an error");
+    }
+
+    {
+        GlobalSet globalSet;
+        answer("C\nDIR\nD\n" + denativePath(directory / "files") + "\n");
+        globalSet.query();
+        // W = {a, with space} and Y = {a, b} in the directory set, with every kind of set computed from them, a faux word set,
+        // and a word set nested in the intersection that is not included in human readable output
+        answer(
+            "E\nDIR\n"
+            "C\nW\nW\nE\nW\nV\nA\na\nA\nwith space\nX\nX\n"
+            "C\nY\nW\nE\nY\nV\nA\na\nA\nb\nX\nX\n"
+            "C\nI\nI\nS\nW\nS\nY\nEXIT\n"
+            "C\nU\nU\nS\nW\nS\nY\nEXIT\n"
+            "C\nD\n-\nS\nW\nS\nY\n"
+            "C\nSD\nS\nS\nW\nS\nY\n"
+            "C\nRC\nC\nS\nW\n"
+            "C\nEX\nE\n(W | Y) - I\n"
+            "C\nF\nF\nE\nF\nV\nA\nb\nA\nnot a file\nX\nX\n"
+            "E\nI\nC\nN\nW\nE\nN\nV\nA\na\nX\nT\nX\nX\n"
+            "X\n"
+        );
+        globalSet.query();
+
+        const auto& directorySet = *globalSet.subsets().at("DIR");
+        check(directorySet.subsets().size() == 9, "every set was created");
+        check(directorySet.subsets().at("EX")->contains("b") && directorySet.subsets().at("EX")->contains("with space") && !directorySet.subsets().at("EX")->contains("a"),
+              "the expression set was computed");
+        check(describe(*directorySet.subsets().at("F")).find("not a file") != std::string::npos, "the faux word set holds a word that is not in its parent");
+        check(!directorySet.subsets().at("I")->subsets().at("N")->humanIncluded, "the nested word set is not included in human readable output");
+
+        auto description = describe(globalSet);
+        auto human = humanOutput(globalSet);
+        std::ostringstream binary;
+        globalSet.saveMachineSubsets(binary);
+        std::ostringstream text;
+        globalSet.saveTextMachineSubsets(text);
+        for (const auto& [location, saved] : {std::pair{directory / "saved.bin", binary.str()}, std::pair{directory / "saved.txt", text.str()}}) {
+            nowide::ofstream saveLocation(denativePath(location), std::ios::out | std::ios::binary);
+            saveLocation.write(saved.data(), saved.size());
+        }
+
+        prompts.str("");
+        for (bool fromText : {false, true}) {
+            {
+                GlobalSet loaded;
+                std::istringstream loadLocation(fromText ? text.str() : binary.str());
+                loaded.loadMachineSubsets(loadLocation);
+                check(describe(loaded) == description, fromText ? "the text encoding loads from a stream" : "the binary encoding loads from a stream");
+                check(humanOutput(loaded) == human, "the sets loaded from a stream have the same human readable output");
+            }
+            {
+                GlobalSet loaded;
+                loaded.loadMachineSubsets(directory / (fromText ? "saved.txt" : "saved.bin"));
+                check(describe(loaded) == description, fromText ? "the text encoding loads from a mapped file" : "the binary encoding loads from a mapped file");
+                check(humanOutput(loaded) == human, "the sets loaded from a mapped file have the same human readable output");
+            }
+        }
+        check(prompts.str().find("ERROR") == std::string::npos, "nothing failed to load");
+
+        answers >> std::ws;
+        check(answers.eof(), "every answer was read");
+    }
+
+    nowide::cin.rdbuf(cinBuffer);
+    nowide::cout.rdbuf(coutBuffer);
+    std::filesystem::current_path(workingDirectory);
+    std::filesystem::remove_all(directory);
+    return testResult();
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+/*
+    test.hpp
+
+    The checks the tests are made of, each of which reports what failed without stopping the test, which then exits with how many checks failed
+*/
+#pragma once
+
+#include <nowide/iostream.hpp>
+
+#include <string_view>
+
+inline int failedChecks = 0;
+
+inline bool check(bool passed, std::string_view description) noexcept {
+    if (!passed) {
+        nowide::cerr << "FAILED: " << description << '\n';
+        ++failedChecks;
+    }
+    return passed;
+}
+
+inline int testResult() noexcept {
+    if (failedChecks > 0) {
+        nowide::cerr << failedChecks << " checks failed\n";
+    }
+    return failedChecks == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+/*
+    thread-pool-test.cpp
+
+    Checks that the pool runs every task on the same threads each time rather than starting new ones, and that a task run from inside of another
+    is left to the calling thread alone instead of waiting on threads that are busy with the outer task
+*/
+#include "thread-pool.hpp"
+
+#include "test.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+
+int main() {
+    ThreadPool threadPool;
+    std::mutex mutex;
+    std::set<std::thread::id> firstThreads;
+    std::set<std::thread::id> threads;
+    for (int task = 0; task < 50; ++task) {
+        std::atomic<size_t> ran(0);
+        auto record = [&] {
+            std::lock_guard<std::mutex> lock(mutex);
+            (task == 0 ? firstThreads : threads).insert(std::this_thread::get_id());
+            ++ran;
+        };
+        threadPool.run(record, record);
+        check(ran == std::max(std::thread::hardware_concurrency(), 1u), "every thread runs every task once");
+    }
+    threads.insert(firstThreads.begin(), firstThreads.end());
+    check(threads == firstThreads, "later tasks run on the threads the first task ran on");
+
+    // the threads of the pool stay busy with the outer task until the nested one returns
+    std::atomic<bool> nestedReturned(false);
+    std::atomic<size_t> nestedOnPool(0);
+    std::atomic<size_t> nestedOnCallingThread(0);
+    threadPool.run([&] {
+        while (!nestedReturned) {
+            std::this_thread::yield();
+        }
+    }, [&] {
+        threadPool.run([&] { ++nestedOnPool; }, [&] { ++nestedOnCallingThread; });
+        nestedReturned = true;
+    });
+    check(nestedOnCallingThread == 1 && nestedOnPool == 0, "a task run from inside of another only runs on the calling thread");
+    return testResult();
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+/*
+    word-set-derived-parent-test.cpp
+
+    Answers the menus of a hierarchy of a directory set with an intersection of two word sets in it, a word set nested in the intersection,
+    and a set computed from that word set, then removes a word from one side of the intersection and checks that the nested word set loses it too,
+    which it kept when the intersection was not a set that passes removed elements on to its subsets, and that the set computed from it follows
+    Removing a word that is not in a set is refused without updating anything, and a parent recomputed in full is checked against in full
+*/
+#include "global-set.hpp"
+
+#include "test.hpp"
+
+#include <nowide/fstream.hpp>
+#include <nowide/iostream.hpp>
+
+#include <filesystem>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace {
+    std::istringstream answers;
+    std::ostringstream prompts;
+
+    // makes the menus read input from here on, until it is all read
+    void answer(const std::string& input) noexcept {
+        answers.clear();
+        answers.str(input);
+    }
+}
+
+int main() {
+    auto directory = std::filesystem::temp_directory_path() / ("set-manager-word-set-derived-parent-test-" + std::to_string(std::random_device()()));
+    std::filesystem::create_directories(directory);
+    for (const char* file : {"a", "b", "c"}) {
+        nowide::ofstream(denativePath(directory / file));
+    }
+    auto* cinBuffer = nowide::cin.rdbuf(answers.rdbuf());
+    auto* coutBuffer = nowide::cout.rdbuf(prompts.rdbuf());
+
+    {
+        GlobalSet globalSet;
+        answer("C\nDIR\nD\n" + denativePath(directory) + "\n");
+        globalSet.query();
+        // A = {a, b} and B = {a, b, c} in the directory set, I = A & B, W = {a} in I with W2 = {a} nested in it, and BW = B & W in the directory set
+        answer(
+            "E\nDIR\n"
+            "C\nA\nW\nE\nA\nV\nA\na\nA\nb\nX\nX\n"
+            "C\nB\nW\nE\nB\nV\nA\na\nA\nb\nA\nc\nX\nX\n"
+            "C\nI\nI\nS\nA\nS\nB\nEXIT\n"
+            "E\nI\nC\nW\nW\nE\nW\nV\nA\na\nX\nC\nW2\nW\nE\nW2\nV\nA\na\nX\nX\nX\nX\n"
+            "C\nBW\nI\nS\nB\nE\nI\nS\nW\nEXIT\n"
+            "X\n"
+        );
+        globalSet.query();
+
+        auto& directorySet = *globalSet.subsets().at("DIR");
+        const auto& setA = *directorySet.subsets().at("A");
+        auto& intersection = *directorySet.subsets().at("I");
+        const auto& words = *intersection.subsets().at("W");
+        const auto& nestedWords = *words.subsets().at("W2");
+        const auto& computedFromWords = *directorySet.subsets().at("BW");
+        check(words.contains("a") && nestedWords.contains("a") && computedFromWords.contains("a"), "the hierarchy was built with the word in every set");
+
+        answer("E\nDIR\nE\nA\nV\nR\na\nX\nX\nX\n");
+        globalSet.query();
+        check(!intersection.contains("a") && intersection.contains("b"), "the intersection lost the word removed from one of its sides");
+        check(!words.contains("a") && !nestedWords.contains("a"), "the word set nested in the intersection, and the word set nested in it, lost the word");
+        check(!computedFromWords.contains("a"), "the set computed from the nested word set lost the word");
+        check(intersection.elementsOutsideParent().empty() && words.elementsOutsideParent().empty(), "no set has elements outside of its parent");
+
+        auto version = setA.version();
+        prompts.str("");
+        answer("E\nDIR\nE\nA\nV\nR\nc\nX\nX\nX\n");
+        globalSet.query();
+        check(setA.version() == version, "removing a word that is not in the set does not update the sets computed from it");
+        check(prompts.str().find("That word is not in the set") != std::string::npos, "removing a word that is not in the set says so");
+
+        // the word set gains b, which is then removed from A in a transaction, so that the intersection is only told of it
+        // once it has already been recomputed and its subsets can only be checked against it in full
+        answer("E\nDIR\nE\nI\nE\nW\nV\nA\nb\nX\nX\nX\nX\n");
+        globalSet.query();
+        check(words.contains("b") && computedFromWords.contains("b"), "the nested word set gained a word of the intersection");
+        answer("BT\n");
+        globalSet.query();
+        answer("E\nDIR\nE\nA\nV\nR\nb\nX\nX\nX\n");
+        globalSet.query();
+        intersection.recompute();
+        intersection.updateDownstream();
+        answer("CT\n");
+        globalSet.query();
+        check(!intersection.contains("b") && !words.contains("b"), "the nested word set lost the word once the intersection was recomputed in full");
+        check(!computedFromWords.contains("b"), "the set computed from the nested word set lost the word once the intersection was recomputed in full");
+        check(prompts.str().find("The transaction was committed.") != std::string::npos, "the transaction was committed");
+
+        answers >> std::ws;
+        check(answers.eof(), "every answer was read");
+    }
+
+    nowide::cin.rdbuf(cinBuffer);
+    nowide::cout.rdbuf(coutBuffer);
+    std::filesystem::remove_all(directory);
+    return testResult();
+}
\ No newline at end of file